@@ -21,6 +21,7 @@
 #include "zxformat.h"
 #include "app_mode.h"
 #include "crypto.h"
+#include "scratch.h"
 
 zxerr_t addr_getNumItems(uint8_t *num_items) {
     zemu_log_stack("addr_getNumItems");
@@ -48,9 +49,13 @@ zxerr_t addr_getItem(int8_t displayIdx,
             }
 
             snprintf(outKey, outKeyLen, "Your Path");
-            char buffer[300];
-            bip32_to_str(buffer, sizeof(buffer), hdPath, HDPATH_LEN_DEFAULT);
-            pageString(outVal, outValLen, buffer, pageIdx, pageCount);
+            scratch_arena_t *scratch = scratch_acquire(scratch_owner_path);
+            if (scratch == NULL) {
+                return zxerr_unknown;
+            }
+            bip32_to_str(scratch->path, sizeof(scratch->path), hdPath, HDPATH_LEN_DEFAULT);
+            pageString(outVal, outValLen, scratch->path, pageIdx, pageCount);
+            scratch_release(scratch_owner_path);
             return zxerr_ok;
         }
         default:
@@ -29,6 +29,8 @@
 #include "addr.h"
 #include "crypto.h"
 #include "coin.h"
+#include "timing.h"
+#include "stack_usage.h"
 #include "zxmacros.h"
 
 static bool tx_initialized = false;
@@ -130,6 +132,84 @@ __Z_INLINE void handleSign(volatile uint32_t *flags, volatile uint32_t *tx, uint
     *flags |= IO_ASYNCH_REPLY;
 }
 
+__Z_INLINE void handleSignOneShot(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
+    zemu_log("handleSignOneShot\n");
+    // Path and transaction arrive in a single APDU
+    const uint32_t pathLength = sizeof(uint32_t) * HDPATH_LEN_DEFAULT;
+    if (rx < OFFSET_DATA + pathLength) {
+        THROW(APDU_CODE_WRONG_LENGTH);
+    }
+    extractHDPath(rx, OFFSET_DATA);
+
+    if (tx_load_ram(G_io_apdu_buffer + OFFSET_DATA + pathLength, rx - OFFSET_DATA - pathLength) != zxerr_ok) {
+        THROW(APDU_CODE_WRONG_LENGTH);
+    }
+
+    const char *error_msg = tx_parse();
+    CHECK_APP_CANARY()
+    if (error_msg != NULL) {
+        const int error_msg_length = strnlen(error_msg, sizeof(G_io_apdu_buffer));
+        memcpy(G_io_apdu_buffer, error_msg, error_msg_length);
+        *tx += (error_msg_length);
+        THROW(APDU_CODE_DATA_INVALID);
+    }
+
+    view_review_init(tx_getItem, tx_getNumItems, app_sign);
+    view_review_show(REVIEW_TXN);
+    *flags |= IO_ASYNCH_REPLY;
+}
+
+__Z_INLINE void handleSignBatchGetSignature(volatile uint32_t *tx, uint32_t rx) {
+    const uint8_t txIdx = G_io_apdu_buffer[OFFSET_P2];
+    if (rx != OFFSET_DATA) {
+        THROW(APDU_CODE_WRONG_LENGTH);
+    }
+    if (tx_batch_get_count() == 0) {
+        THROW(APDU_CODE_COMMAND_NOT_ALLOWED);
+    }
+
+    const uint8_t *message = NULL;
+    uint16_t messageLength = 0;
+    if (tx_batch_get_tx(txIdx, &message, &messageLength) != zxerr_ok) {
+        THROW(APDU_CODE_DATA_INVALID);
+    }
+
+    uint32_t signatureLength = 0;
+    const zxerr_t err = crypto_sign(G_io_apdu_buffer, &signatureLength, IO_APDU_BUFFER_SIZE - 3, message, messageLength);
+    if (err != zxerr_ok) {
+        THROW(APDU_CODE_SIGN_VERIFY_ERROR);
+    }
+
+    *tx = signatureLength;
+    THROW(APDU_CODE_OK);
+}
+
+__Z_INLINE void handleSignBatch(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
+    zemu_log("handleSignBatch\n");
+    if (G_io_apdu_buffer[OFFSET_PAYLOAD_TYPE] == P1_BATCH_GET_SIGNATURE) {
+        handleSignBatchGetSignature(tx, rx);
+        return;
+    }
+
+    tx_batch_set_approved(false);
+    if (!process_chunk(tx, rx)) {
+        THROW(APDU_CODE_OK);
+    }
+
+    const char *error_msg = tx_parse_batch();
+    CHECK_APP_CANARY()
+    if (error_msg != NULL) {
+        const int error_msg_length = strnlen(error_msg, sizeof(G_io_apdu_buffer));
+        memcpy(G_io_apdu_buffer, error_msg, error_msg_length);
+        *tx += (error_msg_length);
+        THROW(APDU_CODE_DATA_INVALID);
+    }
+
+    view_review_init(tx_batch_getItem, tx_batch_getNumItems, app_sign_batch);
+    view_review_show(REVIEW_TXN);
+    *flags |= IO_ASYNCH_REPLY;
+}
+
 __Z_INLINE void handle_getversion(__Z_UNUSED volatile uint32_t *flags, volatile uint32_t *tx)
 {
     G_io_apdu_buffer[0] = 0;
@@ -159,7 +239,23 @@ __Z_INLINE void handle_getversion(__Z_UNUSED volatile uint32_t *flags, volatile
 }
 
 #if defined(APP_TESTING)
-void handleTest(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
+void handleTest(__Z_UNUSED volatile uint32_t *flags, volatile uint32_t *tx, __Z_UNUSED uint32_t rx) {
+    switch (G_io_apdu_buffer[OFFSET_P1]) {
+        case TIMING_P1_READ:
+            *tx = timing_serialize(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE - 2);
+            break;
+        case TIMING_P1_RESET:
+            timing_reset();
+            break;
+        case STACK_P1_PAINT:
+            stack_paint();
+            break;
+        case STACK_P1_READ:
+            *tx = stack_serialize(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE - 2);
+            break;
+        default:
+            THROW(APDU_CODE_INVALIDP1P2);
+    }
     THROW(APDU_CODE_OK);
 }
 #endif
@@ -179,6 +275,16 @@ void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
                 THROW(APDU_CODE_WRONG_LENGTH);
             }
 
+            if (os_global_pin_is_validated() != BOLOS_UX_OK) {
+                // Device is locked, drop cached keys before anything else
+                crypto_clearAddressCache();
+            }
+
+            if (G_io_apdu_buffer[OFFSET_INS] != INS_SIGN_BATCH) {
+                // Any other command may replace the path or the buffer of an approved batch
+                tx_batch_set_approved(false);
+            }
+
             switch (G_io_apdu_buffer[OFFSET_INS]) {
                 case INS_GET_VERSION: {
                     handle_getversion(flags, tx);
@@ -197,6 +303,18 @@ void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
                     break;
                 }
 
+                case INS_SIGN_ONESHOT: {
+                    CHECK_PIN_VALIDATED()
+                    handleSignOneShot(flags, tx, rx);
+                    break;
+                }
+
+                case INS_SIGN_BATCH: {
+                    CHECK_PIN_VALIDATED()
+                    handleSignBatch(flags, tx, rx);
+                    break;
+                }
+
 #if defined(APP_TESTING)
                     case INS_TEST: {
                     handleTest(flags, tx, rx);
@@ -0,0 +1,67 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "budget.h"
+#include "host_build.h"
+
+static APP_THREAD_LOCAL parser_budget_t *active_budget = NULL;
+
+parser_budget_t *budget_enter(parser_budget_t *budget) {
+    parser_budget_t *previous = active_budget;
+    active_budget = budget;
+    return previous;
+}
+
+parser_error_t budget_leave(parser_budget_t *previous, parser_error_t err) {
+    // Helpers without a parser_error_t report exhaustion as a generic failure
+    if (active_budget != NULL && active_budget->exhausted) {
+        err = parser_budget_exhausted;
+    }
+    active_budget = previous;
+    return err;
+}
+
+bool budget_spend(budget_kind_e kind, uint32_t amount) {
+    parser_budget_t *budget = active_budget;
+    if (budget == NULL) {
+        return true;
+    }
+    if (budget->exhausted) {
+        return false;
+    }
+
+    uint32_t *remaining = NULL;
+    switch (kind) {
+        case budget_items:
+            remaining = &budget->items;
+            break;
+        case budget_bytes:
+            remaining = &budget->bytes;
+            break;
+        case budget_div_steps:
+            remaining = &budget->divSteps;
+            break;
+        default:
+            return false;
+    }
+
+    if (*remaining < amount) {
+        *remaining = 0;
+        budget->exhausted = 1;
+        return false;
+    }
+    *remaining -= amount;
+    return true;
+}
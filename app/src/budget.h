@@ -0,0 +1,50 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include "parser_common.h"
+
+// Work budgets bound the cost of parsing and rendering untrusted input.
+// The budget belongs to the parser context; the parser entry points make it the
+// active one for the duration of the call, so helpers that never see a context
+// (rlp_readList, tostring256) can still charge it.
+
+typedef enum {
+    budget_items = 0,
+    budget_bytes,
+    budget_div_steps,
+} budget_kind_e;
+
+/// Makes budget the calling thread's active budget, NULL for unlimited
+/// \return the previously active budget, to be handed to budget_leave
+parser_budget_t *budget_enter(parser_budget_t *budget);
+
+/// Restores the previous budget
+/// \return parser_budget_exhausted if the budget ran out during the call, err otherwise
+parser_error_t budget_leave(parser_budget_t *previous, parser_error_t err);
+
+/// Charges the active budget, always succeeds without one
+/// \return false once the budget is exhausted
+bool budget_spend(budget_kind_e kind, uint32_t amount);
+
+#ifdef __cplusplus
+}
+#endif
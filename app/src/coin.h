@@ -21,6 +21,12 @@ extern "C" {
 
 #define CLA                             0x88
 
+#define INS_SIGN_BATCH                  0x03
+#define INS_SIGN_ONESHOT                0x04
+
+// INS_SIGN_BATCH: once the batch is approved, P1 = 3 and P2 = index retrieve each signature
+#define P1_BATCH_GET_SIGNATURE          0x03
+
 #define HDPATH_LEN_DEFAULT   5
 #define HDPATH_0_DEFAULT     (0x80000000u | 0x2c)   //44
 #define HDPATH_1_DEFAULT     (0x80000000u | 0x13e)  //318
@@ -56,6 +56,15 @@ __Z_INLINE void app_sign() {
     }
 }
 
+__Z_INLINE void app_sign_batch() {
+    // Signatures are computed on demand with P1_BATCH_GET_SIGNATURE, reply with the number of transactions
+    tx_batch_set_approved(true);
+    G_io_apdu_buffer[0] = tx_batch_get_count();
+
+    set_code(G_io_apdu_buffer, 1, APDU_CODE_OK);
+    io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, 3);
+}
+
 __Z_INLINE void app_reject() {
     MEMZERO(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE);
     set_code(G_io_apdu_buffer, 0, APDU_CODE_COMMAND_NOT_ALLOWED);
@@ -30,6 +30,13 @@ parser_error_t parser_parse(parser_context_t *ctx,
                             const uint8_t *data,
                             size_t dataLen);
 
+//// parses a tx buffer, charging budget; validate and getItem keep charging it
+//// until the context is parsed again
+parser_error_t parser_parseBudgeted(parser_context_t *ctx,
+                                    const uint8_t *data,
+                                    size_t dataLen,
+                                    parser_budget_t *budget);
+
 //// verifies tx fields
 parser_error_t parser_validate(parser_context_t *ctx);
 
@@ -43,6 +50,25 @@ parser_error_t parser_getItem(const parser_context_t *ctx,
                               char *outVal, uint16_t outValLen,
                               uint8_t pageIdx, uint8_t *pageCount);
 
+//// splits a packed batch of transactions, parses and validates each of them
+parser_error_t parser_batch_parse(parser_batch_t *batch,
+                                  const uint8_t *data,
+                                  size_t dataLen);
+
+//// returns the number of items in the consolidated batch review
+parser_error_t parser_batch_getNumItems(const parser_batch_t *batch, uint8_t *num_items);
+
+// retrieves a readable output for each field / page of the batch review
+parser_error_t parser_batch_getItem(const parser_batch_t *batch,
+                                    uint8_t displayIdx,
+                                    char *outKey, uint16_t outKeyLen,
+                                    char *outVal, uint16_t outValLen,
+                                    uint8_t pageIdx, uint8_t *pageCount);
+
+// retrieves the raw bytes of a single transaction in the batch
+parser_error_t parser_batch_getTx(const parser_batch_t *batch, uint8_t txIdx,
+                                  const uint8_t **tx, uint16_t *txLen);
+
 #ifdef __cplusplus
 }
 #endif
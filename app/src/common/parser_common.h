@@ -20,13 +20,14 @@ extern "C" {
 #endif
 
 #include "parser_txdef.h"
+#include "trace.h"
 #include <stdint.h>
 #include <stddef.h>
 
 #define CHECK_ERROR(__CALL) { \
     parser_error_t __err = __CALL;  \
     CHECK_APP_CANARY()  \
-    if (__err!=parser_ok) return __err;}
+    if (__err!=parser_ok) { TRACE_ERROR(__err) return __err;}}
 
 typedef enum {
     // Generic errors
@@ -53,13 +54,25 @@ typedef enum {
     parser_unexpected_chain,
     parser_missing_field,
     paser_unknown_transaction,
+    parser_scratch_exhausted,
+    parser_rlp_too_deep,
+    parser_budget_exhausted,
 } parser_error_t;
 
+/// Work still allowed to the calls that run with this budget, see budget.h
+typedef struct {
+    uint32_t items;             // RLP items read
+    uint32_t bytes;             // characters rendered by the paging helpers
+    uint32_t divSteps;          // uint256 division steps, one per printed digit
+    uint8_t exhausted;
+} parser_budget_t;
+
 typedef struct {
     const uint8_t *buffer;
     uint16_t bufferLen;
     uint16_t offset;
     parser_tx_t *tx_obj;
+    parser_budget_t *budget;    // NULL: unlimited
 } parser_context_t;
 
 #ifdef __cplusplus
@@ -0,0 +1,63 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "stack_usage.h"
+
+#if defined(APP_TESTING)
+
+#include "zxmacros.h"
+
+#define STACK_PAINT_PATTERN     0xA5u
+// Keep away from the frames that are live while painting
+#define STACK_PAINT_MARGIN      64u
+
+// Provided by the linker script, the canary sits at the bottom of the stack
+extern uint32_t app_stack_canary;
+extern uint8_t _estack;
+
+static uint8_t *stack_bottom() {
+    return (uint8_t *) &app_stack_canary + sizeof(app_stack_canary);
+}
+
+void stack_paint() {
+    volatile uint8_t marker = 0;
+    uint8_t *const limit = (uint8_t *) &marker - STACK_PAINT_MARGIN;
+    for (volatile uint8_t *p = stack_bottom(); p < limit; p++) {
+        *p = STACK_PAINT_PATTERN;
+    }
+}
+
+uint16_t stack_serialize(uint8_t *buffer, uint16_t bufferLen) {
+    if (buffer == NULL || bufferLen < STACK_REPORT_LEN) {
+        return 0;
+    }
+
+    const uint8_t *p = stack_bottom();
+    while (p < &_estack && *p == STACK_PAINT_PATTERN) {
+        p++;
+    }
+
+    const uint16_t size = (uint16_t) (&_estack - stack_bottom());
+    const uint16_t used = (uint16_t) (&_estack - p);
+
+    buffer[0] = (uint8_t) (size >> 8);
+    buffer[1] = (uint8_t) size;
+    buffer[2] = (uint8_t) (used >> 8);
+    buffer[3] = (uint8_t) used;
+    return STACK_REPORT_LEN;
+}
+
+#endif
@@ -0,0 +1,44 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// INS_TEST sub-commands (P1)
+#define STACK_P1_PAINT      0x02
+#define STACK_P1_READ       0x03
+
+// Response: stack size (2) | high-water mark (2), big endian
+#define STACK_REPORT_LEN    4u
+
+#if defined(APP_TESTING)
+
+/// Fills the unused part of the stack with a known pattern
+void stack_paint();
+
+/// Serializes the stack size and the deepest usage seen since the last paint
+/// \return number of bytes written (0 if buffer is too small)
+uint16_t stack_serialize(uint8_t *buffer, uint16_t bufferLen);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
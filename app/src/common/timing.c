@@ -0,0 +1,55 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "timing.h"
+
+#if defined(APP_TESTING)
+
+#include "zxmacros.h"
+
+static uint16_t timing_calls[TIMING_STAGE_COUNT];
+
+void timing_reset() {
+    MEMZERO(timing_calls, sizeof(timing_calls));
+}
+
+void timing_count(timing_stage_e stage) {
+    if (stage >= TIMING_STAGE_COUNT) {
+        return;
+    }
+    if (timing_calls[stage] < UINT16_MAX) {
+        timing_calls[stage]++;
+    }
+}
+
+uint16_t timing_serialize(uint8_t *buffer, uint16_t bufferLen) {
+    if (buffer == NULL || bufferLen < TIMING_TABLE_LEN) {
+        return 0;
+    }
+
+    uint8_t *p = buffer;
+    *p++ = TIMING_STAGE_COUNT;
+
+    for (uint8_t i = 0; i < TIMING_STAGE_COUNT; i++) {
+        *p++ = i;
+        *p++ = (uint8_t) (timing_calls[i] >> 8);
+        *p++ = (uint8_t) timing_calls[i];
+    }
+
+    return (uint16_t) (p - buffer);
+}
+
+#endif
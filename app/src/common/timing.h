@@ -0,0 +1,71 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+typedef enum {
+    timing_stage_append = 0,
+    timing_stage_parse,
+    timing_stage_validate,
+    timing_stage_get_item,
+    timing_stage_derive,
+    timing_stage_hash,
+    timing_stage_sign,
+    TIMING_STAGE_COUNT,
+} timing_stage_e;
+
+// INS_TEST sub-commands (P1)
+#define TIMING_P1_READ      0x00
+#define TIMING_P1_RESET     0x01
+
+// Per stage: id (1) | calls (2), big endian
+#define TIMING_ENTRY_LEN    3u
+// Header: number of stages (1)
+#define TIMING_HEADER_LEN   1u
+#define TIMING_TABLE_LEN    (TIMING_HEADER_LEN + TIMING_STAGE_COUNT * TIMING_ENTRY_LEN)
+
+#if defined(APP_TESTING)
+
+// Apps have no clock that moves while a stage runs: G_io_app.ms is only advanced by
+// ticker events handled inside io_exchange. Only the number of times each stage is
+// entered is recorded; latency has to be measured from the host.
+
+/// Clears all recorded counts
+void timing_reset();
+
+/// Counts a call of the stage, made on entry so that early exits are counted too
+void timing_count(timing_stage_e stage);
+
+/// Serializes the count table into buffer
+/// \return number of bytes written (0 if buffer is too small)
+uint16_t timing_serialize(uint8_t *buffer, uint16_t bufferLen);
+
+#define TIMING_COUNT(__STAGE) timing_count(__STAGE);
+
+#else
+
+#define TIMING_COUNT(__STAGE)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
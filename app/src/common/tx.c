@@ -18,6 +18,7 @@
 #include "apdu_codes.h"
 #include "buffering.h"
 #include "parser.h"
+#include "timing.h"
 #include <string.h>
 #include "zxmacros.h"
 
@@ -43,6 +44,8 @@ storage_t NV_CONST N_appdata_impl __attribute__((aligned(64)));
 #endif
 
 static parser_context_t ctx_parsed_tx;
+static parser_batch_t batch_parsed;
+static bool batch_approved = false;
 
 void tx_initialize() {
     buffering_init(
@@ -52,11 +55,29 @@ void tx_initialize() {
         sizeof(N_appdata.buffer));
 }
 
+zxerr_t tx_load_ram(const uint8_t *data, uint32_t length) {
+    if (data == NULL || length == 0) {
+        return zxerr_no_data;
+    }
+    if (length > sizeof(ram_buffer)) {
+        return zxerr_buffer_too_small;
+    }
+
+    // Everything fits in RAM, flash storage is left untouched
+    buffering_init(ram_buffer, sizeof(ram_buffer), NULL, 0);
+    if (buffering_append((uint8_t *) data, length) != length) {
+        return zxerr_buffer_too_small;
+    }
+
+    return zxerr_ok;
+}
+
 void tx_reset() {
     buffering_reset();
 }
 
 uint32_t tx_append(unsigned char *buffer, uint32_t length) {
+    TIMING_COUNT(timing_stage_append)
     return buffering_append(buffer, length);
 }
 
@@ -69,6 +90,7 @@ uint8_t *tx_get_buffer() {
 }
 
 const char *tx_parse() {
+    TIMING_COUNT(timing_stage_parse)
     parser_error_t err = parser_parse(&ctx_parsed_tx,
                                       tx_get_buffer(),
                                       tx_get_buffer_length());
@@ -78,6 +100,7 @@ const char *tx_parse() {
         return parser_getErrorDescription(err);
     }
 
+    TIMING_COUNT(timing_stage_validate)
     err = parser_validate(&ctx_parsed_tx);
     CHECK_APP_CANARY()
 
@@ -111,6 +134,7 @@ zxerr_t tx_getItem(int8_t displayIdx,
         return zxerr_no_data;
     }
 
+    TIMING_COUNT(timing_stage_get_item)
     parser_error_t err = parser_getItem(&ctx_parsed_tx,
                                         displayIdx,
                                         outKey, outKeyLen,
@@ -128,3 +152,79 @@ zxerr_t tx_getItem(int8_t displayIdx,
 
     return zxerr_ok;
 }
+
+const char *tx_parse_batch() {
+    batch_approved = false;
+    parser_error_t err = parser_batch_parse(&batch_parsed,
+                                            tx_get_buffer(),
+                                            tx_get_buffer_length());
+    CHECK_APP_CANARY()
+
+    if (err != parser_ok) {
+        MEMZERO(&batch_parsed, sizeof(batch_parsed));
+        return parser_getErrorDescription(err);
+    }
+
+    return NULL;
+}
+
+void tx_batch_set_approved(bool approved) {
+    batch_approved = approved && batch_parsed.count > 0;
+}
+
+uint8_t tx_batch_get_count() {
+    return batch_approved ? batch_parsed.count : 0;
+}
+
+zxerr_t tx_batch_get_tx(uint8_t txIdx, const uint8_t **message, uint16_t *messageLength) {
+    if (!batch_approved) {
+        return zxerr_unknown;
+    }
+
+    if (parser_batch_getTx(&batch_parsed, txIdx, message, messageLength) != parser_ok) {
+        return zxerr_out_of_bounds;
+    }
+
+    return zxerr_ok;
+}
+
+zxerr_t tx_batch_getNumItems(uint8_t *num_items) {
+    parser_error_t err = parser_batch_getNumItems(&batch_parsed, num_items);
+
+    if (err != parser_ok) {
+        return zxerr_unknown;
+    }
+
+    return zxerr_ok;
+}
+
+zxerr_t tx_batch_getItem(int8_t displayIdx,
+                         char *outKey, uint16_t outKeyLen,
+                         char *outVal, uint16_t outValLen,
+                         uint8_t pageIdx, uint8_t *pageCount)
+{
+    uint8_t numItems = 0;
+
+    CHECK_ZXERR(tx_batch_getNumItems(&numItems))
+
+    if (displayIdx < 0 || displayIdx >= numItems) {
+        return zxerr_no_data;
+    }
+
+    parser_error_t err = parser_batch_getItem(&batch_parsed,
+                                              displayIdx,
+                                              outKey, outKeyLen,
+                                              outVal, outValLen,
+                                              pageIdx, pageCount);
+
+    // Convert error codes
+    if (err == parser_no_data ||
+        err == parser_display_idx_out_of_range ||
+        err == parser_display_page_out_of_range)
+        return zxerr_no_data;
+
+    if (err != parser_ok)
+        return zxerr_unknown;
+
+    return zxerr_ok;
+}
@@ -21,6 +21,12 @@
 
 void tx_initialize();
 
+/// Loads a complete transaction into the RAM buffer, without using flash storage
+/// \param data
+/// \param length
+/// \return zxerr_buffer_too_small if the transaction does not fit in RAM
+zxerr_t tx_load_ram(const uint8_t *data, uint32_t length);
+
 /// Clears the transaction buffer
 void tx_reset();
 
@@ -52,3 +58,26 @@ zxerr_t tx_getItem(int8_t displayIdx,
                    char *outKey, uint16_t outKeyLen,
                    char *outValue, uint16_t outValueLen,
                    uint8_t pageIdx, uint8_t *pageCount);
+
+/// Parse a packed batch of transactions stored in transaction buffer
+/// Every transaction is prefixed by its length (2 bytes, big endian)
+/// \return It returns NULL if all transactions are valid or error message otherwise.
+const char *tx_parse_batch();
+
+/// Marks the parsed batch as approved (or revokes a previous approval)
+void tx_batch_set_approved(bool approved);
+
+/// Returns the number of transactions in the approved batch (0 if not approved)
+uint8_t tx_batch_get_count();
+
+/// Gets the raw bytes of a transaction in the approved batch
+zxerr_t tx_batch_get_tx(uint8_t txIdx, const uint8_t **message, uint16_t *messageLength);
+
+/// Return the number of items in the consolidated batch review
+zxerr_t tx_batch_getNumItems(uint8_t *num_items);
+
+/// Gets an specific item from the consolidated batch review (including paging)
+zxerr_t tx_batch_getItem(int8_t displayIdx,
+                         char *outKey, uint16_t outKeyLen,
+                         char *outValue, uint16_t outValueLen,
+                         uint8_t pageIdx, uint8_t *pageCount);
@@ -19,10 +19,29 @@
 #include "cx.h"
 #include "zxmacros.h"
 #include "crypto_helper.h"
+#include "timing.h"
 #include <zxformat.h>
 
 uint32_t hdPath[HDPATH_LEN_DEFAULT];
 
+#if defined(TARGET_NANOS)
+#define ADDR_CACHE_ENTRIES 2
+#else
+#define ADDR_CACHE_ENTRIES 4
+#endif
+
+// Public keys and addresses already derived in this session, keyed by HD path
+typedef struct {
+    uint8_t valid;
+    uint32_t path[HDPATH_LEN_DEFAULT];
+    uint8_t pubkey[SECP256K1_PUBKEY_LEN];
+    uint8_t address[ADDRESS_LEN];
+    uint16_t addressLen;
+} addr_cache_entry_t;
+
+static addr_cache_entry_t addrCache[ADDR_CACHE_ENTRIES];
+static uint8_t addrCacheNext = 0;
+
 typedef struct {
     uint8_t r[32];
     uint8_t s[32];
@@ -44,6 +63,7 @@ zxerr_t crypto_extractPublicKey(uint8_t *pubkey, uint16_t pubkeyLen) {
 
     volatile zxerr_t err = zxerr_unknown;
     // Generate keys
+    TIMING_COUNT(timing_stage_derive)
     CATCH_CXERROR(os_derive_bip32_with_seed_no_throw(
         HDW_NORMAL,
         CX_CURVE_256K1,
@@ -81,6 +101,7 @@ zxerr_t crypto_sign(uint8_t *signature, uint32_t *signatureLength, uint16_t sign
 
     volatile zxerr_t err = zxerr_unknown;
     // Generate keys
+    TIMING_COUNT(timing_stage_derive)
     CATCH_CXERROR(os_derive_bip32_no_throw(CX_CURVE_SECP256K1,
                                            hdPath,
                                            HDPATH_LEN_DEFAULT,
@@ -89,10 +110,12 @@ zxerr_t crypto_sign(uint8_t *signature, uint32_t *signatureLength, uint16_t sign
     CATCH_CXERROR(cx_ecfp_init_private_key_no_throw(CX_CURVE_SECP256K1, privateKeyData, SECP256K1_PRIVKEY_LEN, &cx_privateKey))
 
     // Hash the message
+    TIMING_COUNT(timing_stage_hash)
     CATCH_CXERROR(cx_keccak_init_no_throw(&sha3, KECCAK_256_SIZE))
     CATCH_CXERROR(cx_hash_no_throw((cx_hash_t*)&sha3, CX_LAST, message, messageLen, messageDigest, sizeof(messageDigest)))
 
     // Sign
+    TIMING_COUNT(timing_stage_sign)
     CATCH_CXERROR(cx_ecdsa_sign_no_throw(&cx_privateKey,
                                          CX_RND_RFC6979 | CX_LAST,
                                          CX_SHA256,
@@ -132,6 +155,37 @@ zxerr_t keccak_hash(const unsigned char *in, unsigned int inLen,
     return zxerr_ok;
 }
 
+void crypto_clearAddressCache() {
+    MEMZERO(addrCache, sizeof(addrCache));
+    addrCacheNext = 0;
+}
+
+static const addr_cache_entry_t *addrCacheLookup(const uint32_t *path) {
+    for (uint8_t i = 0; i < ADDR_CACHE_ENTRIES; i++) {
+        if (addrCache[i].valid && memcmp(addrCache[i].path, path, sizeof(addrCache[i].path)) == 0) {
+            return &addrCache[i];
+        }
+    }
+    return NULL;
+}
+
+static void addrCacheStore(const uint32_t *path, const uint8_t *pubkey, const uint8_t *address, uint16_t addressLen) {
+    if (addressLen > sizeof_field(addr_cache_entry_t, address)) {
+        return;
+    }
+
+    // Round robin replacement, oldest entry goes first
+    addr_cache_entry_t *entry = &addrCache[addrCacheNext];
+    addrCacheNext = (addrCacheNext + 1) % ADDR_CACHE_ENTRIES;
+
+    MEMZERO(entry, sizeof(*entry));
+    MEMCPY(entry->path, path, sizeof(entry->path));
+    MEMCPY(entry->pubkey, pubkey, sizeof(entry->pubkey));
+    MEMCPY(entry->address, address, addressLen);
+    entry->addressLen = addressLen;
+    entry->valid = 1;
+}
+
 zxerr_t crypto_fillAddress(uint8_t *buffer, uint16_t bufferLen, uint16_t *addrResponseLen)
 {
     if (bufferLen < SECP256K1_PUBKEY_LEN + ADDRESS_LEN) {
@@ -139,6 +193,16 @@ zxerr_t crypto_fillAddress(uint8_t *buffer, uint16_t bufferLen, uint16_t *addrRe
     }
 
     MEMZERO(buffer, bufferLen);
+
+    // Repeated queries for the same account skip derivation and hashing
+    const addr_cache_entry_t *cached = addrCacheLookup(hdPath);
+    if (cached != NULL) {
+        MEMCPY(buffer, cached->pubkey, SECP256K1_PUBKEY_LEN);
+        MEMCPY(buffer + SECP256K1_PUBKEY_LEN, cached->address, cached->addressLen);
+        *addrResponseLen = SECP256K1_PUBKEY_LEN + cached->addressLen;
+        return zxerr_ok;
+    }
+
     CHECK_ZXERR(crypto_extractPublicKey(buffer, bufferLen))
 
     const uint8_t addrLen = crypto_encodePubkey(buffer + SECP256K1_PUBKEY_LEN,
@@ -151,6 +215,8 @@ zxerr_t crypto_fillAddress(uint8_t *buffer, uint16_t bufferLen, uint16_t *addrRe
         return zxerr_encoding_failed;
     }
 
+    addrCacheStore(hdPath, buffer, buffer + SECP256K1_PUBKEY_LEN, addrLen);
+
     *addrResponseLen = SECP256K1_PUBKEY_LEN + addrLen;
     return zxerr_ok;
 }
@@ -27,6 +27,9 @@ extern "C" {
 
 extern uint32_t hdPath[HDPATH_LEN_DEFAULT];
 
+// Forget every public key / address derived so far (e.g. when the device gets locked)
+void crypto_clearAddressCache();
+
 zxerr_t crypto_fillAddress(uint8_t *buffer, uint16_t bufferLen, uint16_t *addrResponseLen);
 
 zxerr_t crypto_sign(uint8_t *signature, uint32_t *signatureLength, uint16_t signatureMaxlen, const uint8_t *message, uint16_t messageLen);
@@ -16,6 +16,7 @@
 #include "crypto_helper.h"
 #include "coin.h"
 #include "base58.h"
+#include "zxmacros.h"
 
 zxerr_t keccak_hash(const unsigned char *in, unsigned int inLen,
                     unsigned char *out, unsigned int outLen);
@@ -47,21 +48,142 @@ uint8_t crc8(const uint8_t *data, size_t data_len) {
     return crc ^ crc8_xor_out;
 }
 
-uint8_t crypto_encodePubkey(uint8_t *buffer, uint16_t buffer_len, const uint8_t *pubkey) {
-    // https://github.com/MatrixAINetwork/TxSend-Sign-Demos/blob/master/Address%20Format.md
-    if (buffer == NULL || pubkey == NULL || buffer_len < ADDRESS_LEN) {
+static const char BASE58_ALPHABET[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+// 58^5 is the largest power of 58 that fits in 32 bits
+#define BASE58_POW5         656356768u
+#define ETH_ADDRESS_LIMBS   (ETH_ADDRESS_LEN / sizeof(uint32_t))
+// 6 rounds of 5 digits cover the 28 digits of a 160-bit value
+#define ETH_ADDRESS_ROUNDS  6u
+
+uint8_t crypto_encodeEthAddress(uint8_t *buffer, uint16_t buffer_len, const uint8_t *ethAddress) {
+    if (buffer == NULL || ethAddress == NULL || buffer_len < ETH_ADDRESS_B58_MAXLEN) {
         return 0;
     }
 
-    uint8_t pubkeyHash[KECCAK_HASH_SIZE] = {0};
-    // We need to skip the prefix for Keccak256 hash
-    if (keccak_hash(pubkey, SECP256K1_PUBKEY_LEN - 1, pubkeyHash, KECCAK_HASH_SIZE) != zxerr_ok) {
-        return 0;
+    uint32_t limbs[ETH_ADDRESS_LIMBS];
+    for (uint8_t i = 0; i < ETH_ADDRESS_LIMBS; i++) {
+        const uint8_t *p = ethAddress + 4 * i;
+        limbs[i] = ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
     }
 
-    // ETH address is obtained with the last 20 bytes
-    const uint8_t *ethAddress = pubkeyHash + 12;
+    // Digits are produced least significant first, 5 per division
+    uint8_t digits[ETH_ADDRESS_ROUNDS * 5];
+    uint8_t first = 0;
+    for (uint8_t round = 0; round < ETH_ADDRESS_ROUNDS; round++) {
+        uint64_t remainder = 0;
+        for (; first < ETH_ADDRESS_LIMBS && limbs[first] == 0; first++);
+        for (uint8_t i = first; i < ETH_ADDRESS_LIMBS; i++) {
+            const uint64_t acc = (remainder << 32) | limbs[i];
+            limbs[i] = (uint32_t) (acc / BASE58_POW5);
+            remainder = acc % BASE58_POW5;
+        }
+
+        uint32_t chunk = (uint32_t) remainder;
+        for (uint8_t j = 0; j < 5; j++) {
+            digits[round * 5 + j] = (uint8_t) (chunk % 58);
+            chunk /= 58;
+        }
+    }
+
+    // Each leading zero byte is kept as a '1', the numeric part has no leading zeros
+    uint8_t zeros = 0;
+    for (; zeros < ETH_ADDRESS_LEN && ethAddress[zeros] == 0; zeros++);
+
+    uint8_t msd = sizeof(digits);
+    for (; msd > 0 && digits[msd - 1] == 0; msd--);
+
+    uint8_t len = 0;
+    for (; len < zeros; len++) {
+        buffer[len] = BASE58_ALPHABET[0];
+    }
+    while (msd > 0) {
+        buffer[len++] = BASE58_ALPHABET[digits[--msd]];
+    }
+    return len;
+}
+
+// Reverse lookup of BASE58_ALPHABET, 0xFF for characters outside the alphabet
+static const uint8_t BASE58_DIGITS[128] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0, 1, 2, 3, 4, 5, 6, 7, 8, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 9, 10, 11, 12, 13, 14, 15, 16, 0xFF, 17, 18, 19, 20, 21, 0xFF,
+    22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 0xFF, 44, 45, 46,
+    47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+#define MAN_PREFIX_LEN      4u
+#define MAN_ADDRESS_MINLEN  (MAN_PREFIX_LEN + 1 + 1)
+#define MAN_ADDRESS_MAXLEN  (MAN_PREFIX_LEN + ETH_ADDRESS_B58_MAXLEN + 1)
+
+zxerr_t crypto_decodeManAddress(const uint8_t *address, uint16_t addressLen, uint8_t *ethAddress) {
+    if (address == NULL || addressLen < MAN_ADDRESS_MINLEN || addressLen > MAN_ADDRESS_MAXLEN) {
+        return zxerr_encoding_failed;
+    }
+    if (address[0] != 'M' || address[1] != 'A' || address[2] != 'N' || address[3] != '.') {
+        return zxerr_encoding_failed;
+    }
+
+    // Last character is the checksum of everything before it
+    const uint16_t checksumIdx = addressLen - 1;
+    if (address[checksumIdx] != (uint8_t) encode_base58_clip(crc8(address, checksumIdx))) {
+        return zxerr_encoding_failed;
+    }
+
+    // Accumulate up to 5 digits at a time, then fold them into the limbs
+    uint32_t limbs[ETH_ADDRESS_LIMBS] = {0};
+    uint16_t idx = MAN_PREFIX_LEN;
+    while (idx < checksumIdx) {
+        uint32_t group = 0;
+        uint32_t scale = 1;
+        for (uint8_t n = 0; n < 5 && idx < checksumIdx; n++, idx++) {
+            const uint8_t c = address[idx];
+            const uint8_t digit = c < sizeof(BASE58_DIGITS) ? BASE58_DIGITS[c] : 0xFF;
+            if (digit == 0xFF) {
+                return zxerr_encoding_failed;
+            }
+            group = group * 58 + digit;
+            scale *= 58;
+        }
+
+        uint64_t carry = group;
+        for (int8_t i = ETH_ADDRESS_LIMBS - 1; i >= 0; i--) {
+            const uint64_t acc = (uint64_t) limbs[i] * scale + carry;
+            limbs[i] = (uint32_t) acc;
+            carry = acc >> 32;
+        }
+        if (carry != 0) {
+            // Does not fit in 160 bits
+            return zxerr_encoding_failed;
+        }
+    }
+
+    uint8_t decoded[ETH_ADDRESS_LEN];
+    for (uint8_t i = 0; i < ETH_ADDRESS_LIMBS; i++) {
+        decoded[4 * i] = (uint8_t) (limbs[i] >> 24);
+        decoded[4 * i + 1] = (uint8_t) (limbs[i] >> 16);
+        decoded[4 * i + 2] = (uint8_t) (limbs[i] >> 8);
+        decoded[4 * i + 3] = (uint8_t) limbs[i];
+    }
 
+    // Only the canonical encoding is accepted: one '1' per leading zero byte
+    uint8_t leadingOnes = 0;
+    for (; MAN_PREFIX_LEN + leadingOnes < checksumIdx && address[MAN_PREFIX_LEN + leadingOnes] == '1'; leadingOnes++);
+    uint8_t zeros = 0;
+    for (; zeros < ETH_ADDRESS_LEN && decoded[zeros] == 0; zeros++);
+    if (leadingOnes != zeros) {
+        return zxerr_encoding_failed;
+    }
+
+    if (ethAddress != NULL) {
+        MEMCPY(ethAddress, decoded, ETH_ADDRESS_LEN);
+    }
+    return zxerr_ok;
+}
+
+static uint8_t encodeManAddress(uint8_t *buffer, uint16_t buffer_len, const uint8_t *ethAddress) {
     buffer[0] = 'M';
     buffer[1] = 'A';
     buffer[2] = 'N';
@@ -69,8 +191,8 @@ uint8_t crypto_encodePubkey(uint8_t *buffer, uint16_t buffer_len, const uint8_t
 
     uint8_t *addrPtr = buffer + 4;
 
-    size_t outlen = 100;
-    if (encode_base58(ethAddress, ETH_ADDRESS_LEN, (unsigned char *) addrPtr, &outlen) != 0) {
+    const uint8_t outlen = crypto_encodeEthAddress(addrPtr, buffer_len - 4, ethAddress);
+    if (outlen == 0) {
         return 0;
     }
     addrPtr += outlen;
@@ -83,3 +205,55 @@ uint8_t crypto_encodePubkey(uint8_t *buffer, uint16_t buffer_len, const uint8_t
     *addrPtr = 0;
     return (uint8_t) (addrPtr - buffer);
 }
+
+uint8_t crypto_encodePubkey(uint8_t *buffer, uint16_t buffer_len, const uint8_t *pubkey) {
+    // https://github.com/MatrixAINetwork/TxSend-Sign-Demos/blob/master/Address%20Format.md
+    if (buffer == NULL || pubkey == NULL || buffer_len < ADDRESS_LEN) {
+        return 0;
+    }
+
+    uint8_t pubkeyHash[KECCAK_HASH_SIZE] = {0};
+    // We need to skip the prefix for Keccak256 hash
+    if (keccak_hash(pubkey, SECP256K1_PUBKEY_LEN - 1, pubkeyHash, KECCAK_HASH_SIZE) != zxerr_ok) {
+        return 0;
+    }
+
+    // ETH address is obtained with the last 20 bytes
+    return encodeManAddress(buffer, buffer_len, pubkeyHash + 12);
+}
+
+#if defined(APP_HOST_BUILD)
+#include "keccak.h"
+
+#define ENCODE_BATCH_CHUNK 8
+
+zxerr_t crypto_encodePubkeys(uint8_t (*addresses)[ADDRESS_LEN], uint8_t *addressLens,
+                             const uint8_t (*pubkeys)[SECP256K1_PUBKEY_LEN - 1], uint16_t count) {
+    if (addresses == NULL || addressLens == NULL || pubkeys == NULL) {
+        return zxerr_no_data;
+    }
+
+    uint8_t hashes[ENCODE_BATCH_CHUNK][KECCAK_HASH_SIZE];
+    const unsigned char *in[ENCODE_BATCH_CHUNK];
+    unsigned char *out[ENCODE_BATCH_CHUNK];
+
+    for (uint16_t done = 0; done < count;) {
+        const uint16_t chunk = (count - done) < ENCODE_BATCH_CHUNK ? (count - done) : ENCODE_BATCH_CHUNK;
+        for (uint16_t i = 0; i < chunk; i++) {
+            in[i] = pubkeys[done + i];
+            out[i] = hashes[i];
+        }
+        CHECK_ZXERR(keccak_hash_batch(in, SECP256K1_PUBKEY_LEN - 1, out, KECCAK_HASH_SIZE, chunk))
+
+        for (uint16_t i = 0; i < chunk; i++) {
+            addressLens[done + i] = encodeManAddress(addresses[done + i], ADDRESS_LEN, hashes[i] + 12);
+            if (addressLens[done + i] == 0) {
+                return zxerr_encoding_failed;
+            }
+        }
+        done += chunk;
+    }
+
+    return zxerr_ok;
+}
+#endif
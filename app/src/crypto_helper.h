@@ -19,11 +19,31 @@
 extern "C" {
 #endif
 
+#include "host_build.h"
 #include "zxerror.h"
 
+// Base58 of a 160-bit value takes at most 28 characters
+#define ETH_ADDRESS_B58_MAXLEN  28u
+
+/// Base58 encodes a 20-byte address, leading zero bytes are kept as '1'
+/// \return length of the encoded address (not zero terminated) or 0 on error
+uint8_t crypto_encodeEthAddress(uint8_t *buffer, uint16_t buffer_len, const uint8_t *ethAddress);
+/// Decodes and validates a MAN address: prefix, base58 digits, 160-bit range and CRC8 checksum
+/// \param ethAddress optional, receives the 20-byte address
+/// \return zxerr_ok if the address is valid
+zxerr_t crypto_decodeManAddress(const uint8_t *address, uint16_t addressLen, uint8_t *ethAddress);
 uint8_t crypto_encodePubkey(uint8_t *buffer, uint16_t buffer_len, const uint8_t *pubkey);
 uint8_t crc8(const uint8_t *data, size_t data_len);
 
+#if defined(APP_HOST_BUILD)
+#include "coin.h"
+
+/// Host only: encodes `count` pubkeys (uncompressed, without prefix) into MAN addresses,
+/// hashing them in SIMD batches
+zxerr_t crypto_encodePubkeys(uint8_t (*addresses)[ADDRESS_LEN], uint8_t *addressLens,
+                             const uint8_t (*pubkeys)[SECP256K1_PUBKEY_LEN - 1], uint16_t count);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
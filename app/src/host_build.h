@@ -0,0 +1,28 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+// Device builds name their model through TARGET_*, anything else is a host build
+#if !defined(TARGET_NANOS) && !defined(TARGET_NANOX) && !defined(TARGET_NANOS2) && !defined(TARGET_STAX)
+#define APP_HOST_BUILD
+#endif
+
+// Device builds are single threaded, host builds keep one copy per thread
+#if defined(APP_HOST_BUILD)
+#define APP_THREAD_LOCAL __thread
+#else
+#define APP_THREAD_LOCAL
+#endif
@@ -0,0 +1,78 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include "host_build.h"
+#include "parser_common.h"
+
+// Parser statistics, host builds with PARSER_METRICS only. Without it every
+// METRICS_* macro expands to nothing.
+
+#if defined(PARSER_METRICS) && !defined(APP_HOST_BUILD)
+#error "PARSER_METRICS is only available on host builds"
+#endif
+
+#define METRICS_ERROR_KINDS     32u
+#define METRICS_TX_TYPES        256u
+// Bucket i counts calls that took [2^(i-1), 2^i) ns, bucket 0 is under 1 ns
+#define METRICS_LATENCY_BUCKETS 40u
+
+typedef enum {
+    metrics_op_parse = 0,
+    metrics_op_validate,
+    metrics_op_getItem,
+    METRICS_OPS,
+} metrics_op_e;
+
+typedef struct {
+    uint64_t txs;                                           // successful parser_parse calls
+    uint64_t bytes;                                         // bytes of those transactions
+    uint64_t recipients;
+    uint64_t txTypes[METRICS_TX_TYPES];
+    uint64_t results[METRICS_OPS][METRICS_ERROR_KINDS];     // parser_error_t of every call
+    uint64_t latency[METRICS_OPS][METRICS_LATENCY_BUCKETS];
+} parser_metrics_t;
+
+uint64_t metrics_now(void);
+/// Counts a call of op that started at `start` (metrics_now) and returned err
+void metrics_record(metrics_op_e op, uint64_t start, parser_error_t err);
+/// Counts a parsed transaction
+void metrics_recordTx(size_t bytes, uint8_t txType, uint16_t recipients);
+
+/// Sums the counters of every thread, live or exited
+void metrics_snapshot(parser_metrics_t *out);
+/// Adds from into into
+void metrics_merge(parser_metrics_t *into, const parser_metrics_t *from);
+
+#ifdef PARSER_METRICS
+#define METRICS_START(__start)                  const uint64_t __start = metrics_now();
+#define METRICS_RECORD(__op, __start, __err)    metrics_record(__op, __start, __err);
+#define METRICS_TX(__bytes, __tx)               metrics_recordTx(__bytes, (__tx)->extraTxType, (__tx)->extraToFieldsItems);
+#else
+#define METRICS_START(__start)
+#define METRICS_RECORD(__op, __start, __err)
+#define METRICS_TX(__bytes, __tx)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
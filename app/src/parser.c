@@ -14,20 +14,25 @@
 *  limitations under the License.
 ********************************************************************************/
 
+#define TRACE_FILE trace_file_parser
 #include <stdio.h>
 #include <zxmacros.h>
 #include <zxformat.h>
 #include <zxtypes.h>
 
+#include "budget.h"
 #include "coin.h"
 #include "parser_common.h"
 #include "parser_impl.h"
 #include "parser.h"
 #include "rlp.h"
 #include "crypto.h"
+#include "metrics.h"
+#include "scratch.h"
 #include "timeutils.h"
 
-static parser_tx_t tx_obj;
+// One per thread on host builds so independent contexts can parse concurrently
+static APP_THREAD_LOCAL parser_tx_t tx_obj;
 
 zxerr_t keccak_hash(const unsigned char *in, unsigned int inLen,
                     unsigned char *out, unsigned int outLen);
@@ -38,6 +43,7 @@ parser_error_t parser_init_context(parser_context_t *ctx,
     ctx->offset = 0;
     ctx->buffer = NULL;
     ctx->bufferLen = 0;
+    ctx->budget = NULL;
 
     if (bufferSize == 0 || buffer == NULL) {
         // Not available, use defaults
@@ -52,26 +58,73 @@ parser_error_t parser_init_context(parser_context_t *ctx,
     return parser_ok;
 }
 
+static parser_error_t parse(parser_context_t *ctx,
+                            const uint8_t *data,
+                            size_t dataLen,
+                            parser_budget_t *budget) {
+    METRICS_START(start)
+    parser_error_t err = parser_init_context(ctx, data, dataLen);
+    if (err == parser_ok) {
+        ctx->budget = budget;
+        err = _read(ctx, &tx_obj);
+    }
+    if (err == parser_ok) {
+        METRICS_TX(dataLen, &tx_obj)
+    }
+    METRICS_RECORD(metrics_op_parse, start, err)
+    return err;
+}
+
 parser_error_t parser_parse(parser_context_t *ctx,
                             const uint8_t *data,
                             size_t dataLen) {
-    CHECK_ERROR(parser_init_context(ctx, data, dataLen))
-    return _read(ctx, &tx_obj);
+    return parse(ctx, data, dataLen, NULL);
 }
 
-parser_error_t parser_validate(parser_context_t *ctx) {
+parser_error_t parser_parseBudgeted(parser_context_t *ctx,
+                                    const uint8_t *data,
+                                    size_t dataLen,
+                                    parser_budget_t *budget) {
+    return parse(ctx, data, dataLen, budget);
+}
+
+static parser_error_t getItem(const parser_context_t *ctx,
+                              uint8_t displayIdx,
+                              char *outKey, uint16_t outKeyLen,
+                              char *outVal, uint16_t outValLen,
+                              uint8_t pageIdx, uint8_t *pageCount);
+
+static parser_error_t validate(parser_context_t *ctx) {
     // Iterate through all items to check that all can be shown and are valid
     uint8_t numItems = 0;
     CHECK_ERROR(parser_getNumItems(ctx, &numItems))
 
-    char tmpKey[40];
-    char tmpVal[40];
+    scratch_arena_t *scratch = scratch_acquire(scratch_owner_validate);
+    if (scratch == NULL) {
+        return parser_unexpected_error;
+    }
 
-    for (uint8_t idx = 0; idx < numItems; idx++) {
+    parser_error_t err = parser_ok;
+    // Internal getItem: these renders are part of validate, not getItem calls in metrics and traces
+    for (uint8_t idx = 0; idx < numItems && err == parser_ok; idx++) {
         uint8_t pageCount = 0;
-        CHECK_ERROR(parser_getItem(ctx, idx, tmpKey, sizeof(tmpKey), tmpVal, sizeof(tmpVal), 0, &pageCount))
+        err = getItem(ctx, idx,
+                      scratch->validate.key, sizeof(scratch->validate.key),
+                      scratch->validate.val, sizeof(scratch->validate.val),
+                      0, &pageCount);
+        CHECK_APP_CANARY()
     }
-    return parser_ok;
+
+    scratch_release(scratch_owner_validate);
+    return err;
+}
+
+parser_error_t parser_validate(parser_context_t *ctx) {
+    METRICS_START(start)
+    parser_budget_t *previous = budget_enter(ctx != NULL ? ctx->budget : NULL);
+    const parser_error_t err = budget_leave(previous, validate(ctx));
+    METRICS_RECORD(metrics_op_validate, start, err)
+    return err;
 }
 
 parser_error_t parser_getNumItems(const parser_context_t *ctx, uint8_t *num_items) {
@@ -116,6 +169,23 @@ static parser_error_t printCommitTime(const uint256_t *value, char* outVal, uint
     return parser_ok;
 }
 
+// The paging helpers live in zxlib, charge the page before rendering it
+static parser_error_t pageRlp(const rlp_t *rlp, bool hex, char *outVal, uint16_t outValLen,
+                              uint8_t pageIdx, uint8_t *pageCount) {
+    const uint32_t rendered = hex ? 2 * (uint32_t) rlp->rlpLen : (uint32_t) rlp->rlpLen;
+    const uint32_t pageLen = outValLen > 0 ? outValLen - 1u : 0;
+    if (!budget_spend(budget_bytes, rendered < pageLen ? rendered : pageLen)) {
+        return parser_budget_exhausted;
+    }
+
+    if (hex) {
+        pageStringHex(outVal, outValLen, (const char*) rlp->ptr, rlp->rlpLen, pageIdx, pageCount);
+    } else {
+        pageStringExt(outVal, outValLen, (const char*) rlp->ptr, rlp->rlpLen, pageIdx, pageCount);
+    }
+    return parser_ok;
+}
+
 static parser_error_t printDataField(const rlp_t *rlp, const tx_fields_e extraTxType,
                                     char *outVal, uint16_t outValLen,
                                     uint8_t pageIdx, uint8_t *pageCount) {
@@ -127,13 +197,13 @@ static parser_error_t printDataField(const rlp_t *rlp, const tx_fields_e extraTx
         case MANTX_TXTYPE_AUTHORIZED:
         case MANTX_TXTYPE_CREATE_CURR:
         case MANTX_TXTYPE_CANCEL_AUTH:
-            pageStringExt(outVal, outValLen, (const char*) rlp->ptr, rlp->rlpLen, pageIdx, pageCount);
+            CHECK_ERROR(pageRlp(rlp, false, outVal, outValLen, pageIdx, pageCount))
             break;
 
         case MANTX_TXTYPE_NORMAL:
         case MANTX_TXTYPE_SCHEDULED:
         case MANTX_TXTYPE_REVERT:
-            pageStringHex(outVal, outValLen, (const char*) rlp->ptr, rlp->rlpLen, pageIdx, pageCount);
+            CHECK_ERROR(pageRlp(rlp, true, outVal, outValLen, pageIdx, pageCount))
             break;
 
         // case MANTX_TXTYPE_BROADCAST:
@@ -227,9 +297,7 @@ static parser_error_t printExtraFields(const parser_tx_t *txObj, uint8_t display
     switch (fieldIdx) {
         case 0:
             snprintf(outKey, outKeyLen, "To [%d]", extraToIdx);
-            pageStringExt(outVal, outValLen, (const char*) tmpList[fieldIdx].ptr, tmpList[fieldIdx].rlpLen,
-                          pageIdx, pageCount);
-            err = parser_ok;
+            err = pageRlp(&tmpList[fieldIdx], false, outVal, outValLen, pageIdx, pageCount);
             break;
 
         case 1:
@@ -240,10 +308,7 @@ static parser_error_t printExtraFields(const parser_tx_t *txObj, uint8_t display
 
         case 2:
             snprintf(outKey, outKeyLen, "Payload [%d]", extraToIdx);
-            pageStringExt(outVal, outValLen, (const char*) tmpList[fieldIdx].ptr, tmpList[fieldIdx].rlpLen,
-                          pageIdx, pageCount);
-
-            err = parser_ok;
+            err = pageRlp(&tmpList[fieldIdx], false, outVal, outValLen, pageIdx, pageCount);
             break;
 
         default:
@@ -258,7 +323,7 @@ static parser_error_t printExtraFields(const parser_tx_t *txObj, uint8_t display
     return err;
 }
 
-parser_error_t parser_getItem(const parser_context_t *ctx,
+static parser_error_t getItem(const parser_context_t *ctx,
                               uint8_t displayIdx,
                               char *outKey, uint16_t outKeyLen,
                               char *outVal, uint16_t outValLen,
@@ -293,8 +358,7 @@ parser_error_t parser_getItem(const parser_context_t *ctx,
 
         case MANTX_FIELD_TO:
             snprintf(outKey, outKeyLen, "To");
-            pageStringExt(outVal, outValLen, (const char*) rlpPtr->ptr, rlpPtr->rlpLen, pageIdx, pageCount);
-            return parser_ok;
+            return pageRlp(rlpPtr, false, outVal, outValLen, pageIdx, pageCount);
 
         case MANTX_FIELD_VALUE:
             snprintf(outKey, outKeyLen, "Value");
@@ -321,13 +385,13 @@ parser_error_t parser_getItem(const parser_context_t *ctx,
 
         case MANTX_FIELD_ISENTRUSTTX:
             snprintf(outKey, outKeyLen, "IsEntrustTx");
-            rlpPtr = &ctx->tx_obj->fields[displayIdx + 2];
+            rlpPtr = &ctx->tx_obj->fields[MANTX_ROOT_ISENTRUSTTX];
             CHECK_ERROR(rlp_readUInt256(rlpPtr, &value))
             return tostring256(&value, DECIMAL_BASE, outVal, outValLen) ? parser_ok : parser_unexpected_error;
 
         case MANTX_FIELD_COMMITTIME:
             snprintf(outKey, outKeyLen, "CommitTime");
-            rlpPtr = &ctx->tx_obj->fields[displayIdx + 2];
+            rlpPtr = &ctx->tx_obj->fields[MANTX_ROOT_COMMITTIME];
             CHECK_ERROR(rlp_readUInt256(rlpPtr, &value))
             return printCommitTime(&value, outVal, outValLen);
 
@@ -349,3 +413,275 @@ parser_error_t parser_getItem(const parser_context_t *ctx,
 
     return parser_no_data;
 }
+
+parser_error_t parser_getItem(const parser_context_t *ctx,
+                              uint8_t displayIdx,
+                              char *outKey, uint16_t outKeyLen,
+                              char *outVal, uint16_t outValLen,
+                              uint8_t pageIdx, uint8_t *pageCount) {
+    METRICS_START(start)
+    parser_budget_t *previous = budget_enter(ctx != NULL ? ctx->budget : NULL);
+    const parser_error_t err = budget_leave(previous,
+        getItem(ctx, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount));
+    METRICS_RECORD(metrics_op_getItem, start, err)
+    TRACE_EVENT(trace_ev_get_item, displayIdx, pageIdx, err)
+    return err;
+}
+
+static parser_error_t addTxValues(const parser_tx_t *txObj, uint256_t *total) {
+    uint256_t value = {0};
+    uint256_t sum = {0};
+
+    CHECK_ERROR(rlp_readUInt256(&txObj->fields[MANTX_FIELD_VALUE], &value))
+    add256(total, &value, &sum);
+    if (gt256(total, &sum)) {
+        return parser_value_out_of_range;
+    }
+    copy256(total, &sum);
+
+    for (uint8_t i = 0; i < txObj->extraToFieldsItems; i++) {
+        rlp_t tmpList[MANTX_EXTRATOFIELD_COUNT] = {0};
+        uint16_t tmpItems = 0;
+        CHECK_ERROR(rlp_readList(&txObj->extraToListFields[i], &tmpList[0], &tmpItems, MANTX_EXTRATOFIELD_COUNT))
+        CHECK_ERROR(rlp_readUInt256(&tmpList[1], &value))
+        add256(total, &value, &sum);
+        if (gt256(total, &sum)) {
+            return parser_value_out_of_range;
+        }
+        copy256(total, &sum);
+    }
+
+    return parser_ok;
+}
+
+static parser_error_t checkZero(const rlp_t *rlp) {
+    uint256_t value = {0};
+    CHECK_ERROR(rlp_readUInt256(rlp, &value))
+    return zero256(&value) ? parser_ok : parser_unexpected_value;
+}
+
+static parser_error_t checkBatchTx(const parser_tx_t *txObj, const parser_batch_t *batch) {
+    // Only plain transfers can be batched: a consolidated review does not show payloads
+    const rlp_t *data = &txObj->fields[MANTX_FIELD_DATA];
+    if (txObj->extraTxType != MANTX_TXTYPE_NORMAL) {
+        return parser_unexpected_type;
+    }
+    if (data->kind != RLP_KIND_STRING || data->rlpLen != 0) {
+        return parser_unexpected_value;
+    }
+
+    // Nor entrusted or locked transfers, and the whole batch goes to one chain
+    CHECK_ERROR(checkZero(&txObj->fields[MANTX_ROOT_ENTERTYPE]))
+    CHECK_ERROR(checkZero(&txObj->fields[MANTX_ROOT_ISENTRUSTTX]))
+    CHECK_ERROR(checkZero(&txObj->extraFields[1]))
+    const rlp_t *chainId = &txObj->fields[MANTX_ROOT_V];
+    if (chainId->kind != RLP_KIND_BYTE || chainId->rlpLen != 0) {
+        return parser_unexpected_value;
+    }
+    if (batch->count > 0 && *chainId->ptr != batch->chainId) {
+        return parser_unexpected_value;
+    }
+
+    for (uint8_t i = 0; i < txObj->extraToFieldsItems; i++) {
+        rlp_t tmpList[MANTX_EXTRATOFIELD_COUNT] = {0};
+        uint16_t tmpItems = 0;
+        CHECK_ERROR(rlp_readList(&txObj->extraToListFields[i], &tmpList[0], &tmpItems, MANTX_EXTRATOFIELD_COUNT))
+        if (tmpList[2].kind != RLP_KIND_STRING || tmpList[2].rlpLen != 0) {
+            return parser_unexpected_value;
+        }
+    }
+    return parser_ok;
+}
+
+parser_error_t parser_batch_parse(parser_batch_t *batch,
+                                  const uint8_t *data,
+                                  size_t dataLen) {
+    if (batch == NULL || data == NULL || dataLen == 0) {
+        return parser_init_context_empty;
+    }
+    if (dataLen > UINT16_MAX) {
+        return parser_value_out_of_range;
+    }
+
+    MEMZERO(batch, sizeof(*batch));
+    batch->buffer = data;
+
+    uint16_t offset = 0;
+    uint16_t items = MANTX_BATCH_HEADER_ITEMS;
+    while (offset < dataLen) {
+        if (batch->count >= MANTX_BATCH_MAX) {
+            return parser_value_out_of_range;
+        }
+        if (dataLen - offset < MANTX_BATCH_LEN_PREFIX) {
+            return parser_unexpected_buffer_end;
+        }
+
+        const uint16_t txLen = (uint16_t) ((data[offset] << 8u) | data[offset + 1]);
+        offset += MANTX_BATCH_LEN_PREFIX;
+        if (txLen == 0 || dataLen - offset < txLen) {
+            return parser_unexpected_buffer_end;
+        }
+
+        parser_context_t ctx = {0};
+        CHECK_ERROR(parser_parse(&ctx, data + offset, txLen))
+        CHECK_ERROR(parser_validate(&ctx))
+        CHECK_ERROR(checkBatchTx(ctx.tx_obj, batch))
+        CHECK_ERROR(addTxValues(ctx.tx_obj, &batch->totalValue))
+
+        items += MANTX_BATCH_TX_ITEMS + 2 * ctx.tx_obj->extraToFieldsItems;
+        if (items > MANTX_BATCH_MAX_ITEMS) {
+            return parser_value_out_of_range;
+        }
+
+        batch->chainId = *ctx.tx_obj->fields[MANTX_ROOT_V].ptr;
+        batch->txOffset[batch->count] = offset;
+        batch->txLen[batch->count] = txLen;
+        batch->txRecipients[batch->count] = (uint8_t) ctx.tx_obj->extraToFieldsItems;
+        batch->count++;
+
+        offset += txLen;
+    }
+
+    return parser_ok;
+}
+
+parser_error_t parser_batch_getNumItems(const parser_batch_t *batch, uint8_t *num_items) {
+    if (batch == NULL || num_items == NULL || batch->count == 0) {
+        return parser_unexpected_error;
+    }
+
+    uint16_t items = MANTX_BATCH_HEADER_ITEMS;
+    for (uint8_t i = 0; i < batch->count; i++) {
+        items += MANTX_BATCH_TX_ITEMS + 2 * batch->txRecipients[i];
+    }
+    if (items > MANTX_BATCH_MAX_ITEMS) {
+        return parser_value_out_of_range;
+    }
+
+    *num_items = (uint8_t) items;
+    return parser_ok;
+}
+
+parser_error_t parser_batch_getTx(const parser_batch_t *batch, uint8_t txIdx,
+                                  const uint8_t **tx, uint16_t *txLen) {
+    if (batch == NULL || tx == NULL || txLen == NULL) {
+        return parser_unexpected_error;
+    }
+    if (txIdx >= batch->count) {
+        return parser_display_idx_out_of_range;
+    }
+
+    *tx = batch->buffer + batch->txOffset[txIdx];
+    *txLen = batch->txLen[txIdx];
+    return parser_ok;
+}
+
+static parser_error_t printMaxFee(const parser_tx_t *txObj, char *outVal, uint16_t outValLen) {
+    uint256_t gasPrice = {0};
+    uint256_t gasLimit = {0};
+    uint256_t fee = {0};
+
+    CHECK_ERROR(rlp_readUInt256(&txObj->fields[MANTX_FIELD_GASPRICE], &gasPrice))
+    CHECK_ERROR(rlp_readUInt256(&txObj->fields[MANTX_FIELD_GASLIMIT], &gasLimit))
+    if (bits256(&gasPrice) + bits256(&gasLimit) > 256) {
+        return parser_value_out_of_range;
+    }
+
+    mul256(&gasPrice, &gasLimit, &fee);
+    return tostring256(&fee, DECIMAL_BASE, outVal, outValLen) ? parser_ok : parser_unexpected_error;
+}
+
+static parser_error_t prefixBatchKey(char *outKey, uint16_t outKeyLen, uint8_t txIdx) {
+    char prefix[8] = {0};
+    const int prefixLen = snprintf(prefix, sizeof(prefix), "Tx %d ", txIdx + 1);
+    const size_t keyLen = strnlen(outKey, outKeyLen);
+    if (prefixLen <= 0 || keyLen + prefixLen >= outKeyLen) {
+        return parser_unexpected_buffer_end;
+    }
+
+    memmove(outKey + prefixLen, outKey, keyLen + 1);
+    MEMCPY(outKey, prefix, prefixLen);
+    return parser_ok;
+}
+
+parser_error_t parser_batch_getItem(const parser_batch_t *batch,
+                                    uint8_t displayIdx,
+                                    char *outKey, uint16_t outKeyLen,
+                                    char *outVal, uint16_t outValLen,
+                                    uint8_t pageIdx, uint8_t *pageCount) {
+    *pageCount = 1;
+    uint8_t numItems = 0;
+    CHECK_ERROR(parser_batch_getNumItems(batch, &numItems))
+    CHECK_APP_CANARY()
+
+    CHECK_ERROR(checkSanity(numItems, displayIdx))
+    cleanOutput(outKey, outKeyLen, outVal, outValLen);
+
+    if (displayIdx == 0) {
+        snprintf(outKey, outKeyLen, "Batch");
+        snprintf(outVal, outValLen, "%d transactions", batch->count);
+        return parser_ok;
+    }
+
+    if (displayIdx == 1) {
+        snprintf(outKey, outKeyLen, "ChainID");
+        snprintf(outVal, outValLen, "%d", batch->chainId);
+        return parser_ok;
+    }
+
+    if (displayIdx == 2) {
+        uint256_t total = {0};
+        copy256(&total, (uint256_t *) &batch->totalValue);
+        snprintf(outKey, outKeyLen, "Total Value");
+        return tostring256(&total, DECIMAL_BASE, outVal, outValLen) ? parser_ok : parser_unexpected_error;
+    }
+
+    // Find the transaction this item belongs to
+    uint8_t itemIdx = displayIdx - MANTX_BATCH_HEADER_ITEMS;
+    uint8_t txIdx = 0;
+    while (txIdx < batch->count) {
+        const uint8_t txItems = MANTX_BATCH_TX_ITEMS + 2 * batch->txRecipients[txIdx];
+        if (itemIdx < txItems) {
+            break;
+        }
+        itemIdx -= txItems;
+        txIdx++;
+    }
+
+    const uint8_t *tx = NULL;
+    uint16_t txLen = 0;
+    CHECK_ERROR(parser_batch_getTx(batch, txIdx, &tx, &txLen))
+
+    parser_context_t ctx = {0};
+    CHECK_ERROR(parser_parse(&ctx, tx, txLen))
+
+    // Same order as the single transaction review
+    switch (itemIdx) {
+        case 0:
+            CHECK_ERROR(parser_getItem(&ctx, MANTX_FIELD_NONCE, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount))
+            break;
+        case 1:
+            CHECK_ERROR(parser_getItem(&ctx, MANTX_FIELD_TO, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount))
+            break;
+        case 2:
+            CHECK_ERROR(parser_getItem(&ctx, MANTX_FIELD_VALUE, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount))
+            break;
+        case 3:
+            snprintf(outKey, outKeyLen, "Max Fee");
+            CHECK_ERROR(printMaxFee(ctx.tx_obj, outVal, outValLen))
+            break;
+        case 4:
+            CHECK_ERROR(parser_getItem(&ctx, MANTX_FIELD_COMMITTIME, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount))
+            break;
+        default: {
+            // Extra recipients: To [j] and Amount [j], payloads are empty for normal transfers
+            const uint8_t extraIdx = (itemIdx - MANTX_BATCH_TX_ITEMS) / 2;
+            const uint8_t fieldIdx = (itemIdx - MANTX_BATCH_TX_ITEMS) % 2;
+            CHECK_ERROR(parser_getItem(&ctx, MANTX_DISPLAY_COUNT + extraIdx * MANTX_EXTRATOFIELD_COUNT + fieldIdx,
+                                       outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount))
+            break;
+        }
+    }
+
+    return prefixBatchKey(outKey, outKeyLen, txIdx);
+}
@@ -14,14 +14,27 @@
 *  limitations under the License.
 ********************************************************************************/
 
+#define TRACE_FILE trace_file_parser_impl
 #include "parser_impl.h"
 #include "rlp.h"
+#include "crypto_helper.h"
+#include "budget.h"
 static parser_error_t validateTxType(uint8_t value);
+static parser_error_t validateAddress(const rlp_t *address, bool allowEmpty);
 
-parser_error_t _read(parser_context_t *ctx, parser_tx_t *v) {
+// Every item the counters cover is overwritten while reading, only the counters need a reset
+static void resetCounters(parser_tx_t *v) {
+    v->rootFieldsItems = 0;
+    v->extraFieldsItems = 0;
+    v->extraToFieldsItems = 0;
+    v->extraTxType = 0;
+}
+
+static parser_error_t readTx(parser_context_t *ctx, parser_tx_t *v) {
     if (ctx == NULL || v == NULL) {
         return parser_unexpected_error;
     }
+    resetCounters(v);
 
     uint16_t rootList = 0;
     // We expect a single root list
@@ -40,8 +53,25 @@ parser_error_t _read(parser_context_t *ctx, parser_tx_t *v) {
         return parser_unexpected_number_items;
     }
 
+    return _readFields(v);
+}
+
+parser_error_t _read(parser_context_t *ctx, parser_tx_t *v) {
+    parser_budget_t *previous = budget_enter(ctx != NULL ? ctx->budget : NULL);
+    const parser_error_t err = budget_leave(previous, readTx(ctx, v));
+    TRACE_EVENT(trace_ev_read, ctx != NULL ? ctx->offset : 0, ctx != NULL ? ctx->bufferLen : 0, err)
+    return err;
+}
+
+static parser_error_t readFields(parser_tx_t *v) {
+    if (v == NULL) {
+        return parser_unexpected_error;
+    }
+
+    CHECK_ERROR(validateAddress(&v->fields[MANTX_FIELD_TO], true))
+
     // Parse Extra fields
-    const rlp_t *extraFieldsList = &v->fields[MANTX_ROOTFIELD_COUNT - 1];
+    const rlp_t *extraFieldsList = &v->fields[MANTX_ROOT_EXTRA];
     rlp_t extraFieldsInnerElements = {0};
     CHECK_ERROR(rlp_readList(extraFieldsList, &extraFieldsInnerElements, &v->extraFieldsItems, 1))
     CHECK_ERROR(rlp_readList(&extraFieldsInnerElements, &v->extraFields[0], &v->extraFieldsItems, MANTX_EXTRAFIELD_COUNT))
@@ -68,12 +98,32 @@ parser_error_t _read(parser_context_t *ctx, parser_tx_t *v) {
             if (tmpItems != MANTX_EXTRATOFIELD_COUNT) {
                 return parser_unexpected_value;
             }
+            CHECK_ERROR(validateAddress(&tmpList[0], false))
         }
     }
 
     return parser_ok;
 }
 
+parser_error_t _readFields(parser_tx_t *v) {
+    const parser_error_t err = readFields(v);
+    TRACE_EVENT(trace_ev_read_fields, 0, v != NULL ? v->extraToFieldsItems : 0, err)
+    return err;
+}
+
+parser_error_t validateAddress(const rlp_t *address, bool allowEmpty) {
+    if (address->kind == RLP_KIND_STRING && address->rlpLen == 0 && allowEmpty) {
+        // Contract creation
+        return parser_ok;
+    }
+
+    if (address->kind != RLP_KIND_STRING || address->rlpLen > UINT8_MAX ||
+        crypto_decodeManAddress(address->ptr, (uint16_t) address->rlpLen, NULL) != zxerr_ok) {
+        return parser_invalid_address;
+    }
+    return parser_ok;
+}
+
 parser_error_t validateTxType(uint8_t value) {
     // Bounds check
     if (value > MANTX_TXTYPE_SUPERBLOCK) {
@@ -118,10 +168,18 @@ const char *parser_getErrorDescription(parser_error_t err) {
             return "Unexpected duplicated field";
         case parser_value_out_of_range:
             return "Value out of range";
+        case parser_invalid_address:
+            return "Invalid address";
         case parser_unexpected_chain:
             return "Unexpected chain";
         case parser_missing_field:
             return "missing field";
+        case parser_scratch_exhausted:
+            return "Scratch buffer exhausted";
+        case parser_rlp_too_deep:
+            return "RLP nesting too deep";
+        case parser_budget_exhausted:
+            return "Work budget exhausted";
 
         case parser_display_idx_out_of_range:
             return "display index out of range";
@@ -26,6 +26,8 @@ extern "C" {
 
 // #{TODO} --> functions to parse, get, process transaction fields
 parser_error_t _read(parser_context_t *c, parser_tx_t *v);
+/// Second half of _read: validates and splits the root fields once v->fields is filled
+parser_error_t _readFields(parser_tx_t *v);
 
 #ifdef __cplusplus
 }
@@ -20,6 +20,7 @@ extern "C" {
 #endif
 
 #include "rlp_def.h"
+#include "uint256.h"
 
 #define MANTX_ROOTFIELD_COUNT 13
 #define MANTX_EXTRAFIELD_COUNT 3
@@ -29,6 +30,14 @@ extern "C" {
 
 #define DECIMAL_BASE 10
 
+// Batch signing: transactions are packed as [len: u16 BE][tx bytes]...
+#define MANTX_BATCH_MAX 8
+#define MANTX_BATCH_LEN_PREFIX 2
+#define MANTX_BATCH_HEADER_ITEMS 3
+#define MANTX_BATCH_TX_ITEMS 5
+// The review indexes items with int8_t, this bounds the recipients of a batch
+#define MANTX_BATCH_MAX_ITEMS INT8_MAX
+
 typedef enum {
     MANTX_TXTYPE_NORMAL = 0,
     MANTX_TXTYPE_BROADCAST = 1,
@@ -69,6 +78,17 @@ typedef enum {
     MANTX_FIELD_EXTRA_TO,
 } tx_fields_e;
 
+// Positions in the root list, the display enum above skips R, S and Extra
+typedef enum {
+    MANTX_ROOT_V = MANTX_FIELD_V,
+    MANTX_ROOT_R,
+    MANTX_ROOT_S,
+    MANTX_ROOT_ENTERTYPE,
+    MANTX_ROOT_ISENTRUSTTX,
+    MANTX_ROOT_COMMITTIME,
+    MANTX_ROOT_EXTRA,
+} tx_root_fields_e;
+
 
 typedef struct {
     rlp_t root;
@@ -81,6 +101,16 @@ typedef struct {
     uint8_t extraTxType;
 } parser_tx_t;
 
+typedef struct {
+    const uint8_t *buffer;
+    uint16_t txOffset[MANTX_BATCH_MAX];
+    uint16_t txLen[MANTX_BATCH_MAX];
+    uint8_t txRecipients[MANTX_BATCH_MAX];
+    uint8_t count;
+    uint8_t chainId;
+    uint256_t totalValue;
+} parser_batch_t;
+
 
 #ifdef __cplusplus
 }
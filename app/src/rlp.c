@@ -13,7 +13,9 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
+#define TRACE_FILE trace_file_rlp
 #include "rlp.h"
+#include "budget.h"
 #include <zxmacros.h>
 
 parser_error_t rlp_parseStream( parser_context_t *ctx,
@@ -42,64 +44,57 @@ static parser_error_t readBytes(parser_context_t *ctx, uint8_t const **buff, uin
     return parser_ok;
 }
 
-static parser_error_t copyBytes(parser_context_t *ctx, uint8_t *buff, uint64_t buffLen) {
-    if (ctx->bufferLen - ctx->offset < buffLen) {
-        return parser_unexpected_buffer_end;
+void rlp_decodePrefix(uint8_t prefix, rlp_kind_e *kind, uint64_t *len, uint8_t *lenBytes) {
+    *len = 0;
+    *lenBytes = 0;
+
+    if (prefix <= RLP_KIND_BYTE_PREFIX) {
+        *kind = RLP_KIND_BYTE;
+    } else if (prefix <= RLP_KIND_STRING_SHORT_MAX) {
+        *kind = RLP_KIND_STRING;
+        *len = prefix - RLP_KIND_STRING_SHORT_MIN;
+    } else if (prefix <= RLP_KIND_STRING_LONG_MAX) {
+        *kind = RLP_KIND_STRING;
+        *lenBytes = prefix - RLP_KIND_STRING_SHORT_MAX;
+    } else if (prefix <= RLP_KIND_LIST_SHORT_MAX) {
+        *kind = RLP_KIND_LIST;
+        *len = prefix - RLP_KIND_LIST_SHORT_MIN;
+    } else {
+        *kind = RLP_KIND_LIST;
+        *lenBytes = prefix - RLP_KIND_LIST_SHORT_MAX;
     }
-    MEMCPY(buff, (ctx->buffer + ctx->offset), buffLen);
-    ctx->offset += buffLen;
-    return parser_ok;
 }
 
 parser_error_t rlp_read(parser_context_t *ctx, rlp_t *rlp) {
     if (ctx == NULL || rlp == NULL) {
         return parser_unexpected_error;
     }
+    if (!budget_spend(budget_items, 1)) {
+        return parser_budget_exhausted;
+    }
 
     const uint8_t *prefixPtr = NULL;
     CHECK_ERROR(readBytes(ctx, &prefixPtr, 1))
-    const uint8_t prefix = *prefixPtr;
 
-    if (prefix <= RLP_KIND_BYTE_PREFIX) {
-        rlp->kind = RLP_KIND_BYTE;
+    uint8_t lenBytes = 0;
+    rlp_decodePrefix(*prefixPtr, &rlp->kind, &rlp->rlpLen, &lenBytes);
+    if (rlp->kind == RLP_KIND_BYTE) {
         rlp->ptr = prefixPtr;
-        rlp->rlpLen = 0;
-
-    } else if (prefix <= RLP_KIND_STRING_SHORT_MAX) {
-        rlp->kind = RLP_KIND_STRING;
-        rlp->rlpLen = prefix - RLP_KIND_STRING_SHORT_MIN;
-        CHECK_ERROR(readBytes(ctx, &rlp->ptr, rlp->rlpLen))
-
-    } else if (prefix <= RLP_KIND_STRING_LONG_MAX) {
-        rlp->kind = RLP_KIND_STRING;
-        const uint8_t bytesLen = prefix - RLP_KIND_STRING_SHORT_MAX;
-        const uint8_t *rlpLenPtr = NULL;
-        CHECK_ERROR(readBytes(ctx, &rlpLenPtr, bytesLen))
-        rlp->rlpLen = 0;
-        for (uint8_t i = 0; i < bytesLen; i++) {
-            rlp->rlpLen <<= 8u;
-            rlp->rlpLen += *(rlpLenPtr + i);
-        }
-        CHECK_ERROR(readBytes(ctx, &rlp->ptr, rlp->rlpLen))
-
-    } else if (prefix <= RLP_KIND_LIST_SHORT_MAX) {
-        rlp->kind = RLP_KIND_LIST;
-        rlp->rlpLen = prefix - RLP_KIND_LIST_SHORT_MIN;
-        CHECK_ERROR(readBytes(ctx, &rlp->ptr, rlp->rlpLen))
+        TRACE_EVENT(trace_ev_rlp_read, prefixPtr - ctx->buffer, 0, parser_ok)
+        return parser_ok;
+    }
 
-    } else if (prefix <= RLP_KIND_LIST_LONG_MAX) {
-        rlp->kind = RLP_KIND_LIST;
-        const uint8_t bytesLen = prefix - RLP_KIND_LIST_SHORT_MAX;
+    if (lenBytes > 0) {
         const uint8_t *rlpLenPtr = NULL;
-        CHECK_ERROR(readBytes(ctx, &rlpLenPtr, bytesLen))
-        rlp->rlpLen = 0;
-        for (uint8_t i = 0; i < bytesLen; i++) {
+        CHECK_ERROR(readBytes(ctx, &rlpLenPtr, lenBytes))
+        for (uint8_t i = 0; i < lenBytes; i++) {
             rlp->rlpLen <<= 8u;
             rlp->rlpLen += *(rlpLenPtr + i);
         }
-        CHECK_ERROR(readBytes(ctx, &rlp->ptr, rlp->rlpLen))
     }
+    CHECK_ERROR(readBytes(ctx, &rlp->ptr, rlp->rlpLen))
 
+    TRACE_EVENT(trace_ev_rlp_read, prefixPtr - ctx->buffer, rlp->rlpLen, parser_ok)
     return parser_ok;
 }
 
@@ -117,21 +112,86 @@ parser_error_t rlp_readUInt256(const rlp_t *rlp, uint256_t *value) {
         return parser_unexpected_error;
     }
 
-    uint8_t tmpBuffer[32] = {0};
-    parser_context_t ctx = {.buffer = rlp->ptr, .bufferLen = rlp->rlpLen, .offset = 0, .tx_obj = NULL};
+    // Decode big endian bytes straight into the limbs, least significant limb first
+    uint64_t *limbs[4] = {&LOWER(LOWER_P(value)), &UPPER(LOWER_P(value)),
+                          &LOWER(UPPER_P(value)), &UPPER(UPPER_P(value))};
+    clear256(value);
+
     switch (rlp->kind) {
         case RLP_KIND_STRING:
-            if (rlp->rlpLen > sizeof(tmpBuffer)) return parser_value_out_of_range;
-            CHECK_ERROR(copyBytes(&ctx, tmpBuffer + (sizeof(tmpBuffer) - rlp->rlpLen), rlp->rlpLen))
+            if (rlp->rlpLen > sizeof(uint256_t)) return parser_value_out_of_range;
+            for (uint16_t i = 0; i < rlp->rlpLen; i++) {
+                const uint16_t significance = rlp->rlpLen - 1 - i;
+                *limbs[significance / 8] |= ((uint64_t) rlp->ptr[i]) << (8 * (significance % 8));
+            }
             break;
         case RLP_KIND_BYTE:
-            tmpBuffer[31] = *rlp->ptr;
+            LOWER(LOWER_P(value)) = *rlp->ptr;
             break;
 
     default:
         return parser_unexpected_type;
     }
 
-    readu256BE(tmpBuffer, value);
+    return parser_ok;
+}
+
+parser_error_t rlp_walk(const uint8_t *buffer, uint16_t bufferLen, rlp_walk_cb_t callback, void *user) {
+    if ((buffer == NULL && bufferLen > 0) || callback == NULL) {
+        return parser_unexpected_error;
+    }
+
+    // Payload start and end of every open list
+    struct {
+        uint16_t start;
+        uint16_t end;
+    } lists[RLP_WALK_MAX_DEPTH];
+    uint8_t depth = 0;
+
+    parser_context_t ctx = {.buffer = buffer, .bufferLen = bufferLen, .offset = 0, .tx_obj = NULL};
+    rlp_walk_t event;
+
+    while (true) {
+        while (depth > 0 && ctx.offset == lists[depth - 1].end) {
+            depth--;
+            event.event = RLP_WALK_LEAVE_LIST;
+            event.depth = depth;
+            event.item.kind = RLP_KIND_LIST;
+            event.item.ptr = buffer + lists[depth].start;
+            event.item.rlpLen = lists[depth].end - lists[depth].start;
+            event.headerLen = 0;
+            event.offset = lists[depth].start;
+            CHECK_ERROR(callback(&event, user))
+        }
+        if (ctx.offset >= ctx.bufferLen) {
+            break;
+        }
+
+        event.offset = ctx.offset;
+        event.depth = depth;
+        CHECK_ERROR(rlp_read(&ctx, &event.item))
+        // Children cannot run past the end of their list
+        if (depth > 0 && ctx.offset > lists[depth - 1].end) {
+            return parser_unexpected_buffer_end;
+        }
+        event.headerLen = (uint16_t) (event.item.ptr - (buffer + event.offset));
+
+        if (event.item.kind != RLP_KIND_LIST) {
+            event.event = RLP_WALK_ITEM;
+            CHECK_ERROR(callback(&event, user))
+            continue;
+        }
+
+        if (depth == RLP_WALK_MAX_DEPTH) {
+            return parser_rlp_too_deep;
+        }
+        event.event = RLP_WALK_ENTER_LIST;
+        CHECK_ERROR(callback(&event, user))
+        lists[depth].start = event.offset + event.headerLen;
+        lists[depth].end = ctx.offset;
+        depth++;
+        ctx.offset = lists[depth - 1].start;
+    }
+
     return parser_ok;
 }
@@ -26,9 +26,37 @@ extern "C" {
 
 parser_error_t rlp_parseStream(parser_context_t *ctx, rlp_t *rlp, uint16_t *fields, uint16_t maxFields);
 parser_error_t rlp_read(parser_context_t *ctx, rlp_t *rlp);
+/// Decodes a prefix byte: the kind and either the payload length (short forms)
+/// or how many big endian length bytes follow (long forms)
+void rlp_decodePrefix(uint8_t prefix, rlp_kind_e *kind, uint64_t *len, uint8_t *lenBytes);
 parser_error_t rlp_readList(const rlp_t *list, rlp_t *fields, uint16_t *listFields, uint16_t maxFields);
 parser_error_t rlp_readUInt256(const rlp_t *rlp, uint256_t *value);
 
+#ifndef RLP_WALK_MAX_DEPTH
+#define RLP_WALK_MAX_DEPTH  16
+#endif
+
+typedef enum {
+    RLP_WALK_ITEM = 0,
+    RLP_WALK_ENTER_LIST,
+    RLP_WALK_LEAVE_LIST,
+} rlp_walk_event_e;
+
+typedef struct {
+    rlp_walk_event_e event;
+    uint8_t depth;              // 0 for top level items
+    uint16_t offset;            // where the item (header included) starts in the walked buffer
+    uint16_t headerLen;         // prefix and length bytes, 0 for single bytes
+    rlp_t item;                 // payload span, a list's payload for enter and leave events
+} rlp_walk_t;
+
+/// Any error returned by the callback stops the walk and is returned by rlp_walk
+typedef parser_error_t (*rlp_walk_cb_t)(const rlp_walk_t *event, void *user);
+
+/// Walks every item of buffer in a single forward pass, depth first. Only open lists are
+/// tracked, nesting beyond RLP_WALK_MAX_DEPTH fails with parser_rlp_too_deep.
+parser_error_t rlp_walk(const uint8_t *buffer, uint16_t bufferLen, rlp_walk_cb_t callback, void *user);
+
 #if 0
 int16_t rlp_decode(const uint8_t *data,
                    uint8_t *kind,
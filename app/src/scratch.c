@@ -0,0 +1,38 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "scratch.h"
+#include "zxmacros.h"
+
+static APP_THREAD_LOCAL scratch_arena_t scratch_arena;
+static APP_THREAD_LOCAL scratch_owner_e scratch_owner = scratch_owner_none;
+
+scratch_arena_t *scratch_acquire(scratch_owner_e owner) {
+    if (owner == scratch_owner_none || scratch_owner != scratch_owner_none) {
+        return NULL;
+    }
+    scratch_owner = owner;
+    MEMZERO(&scratch_arena, sizeof(scratch_arena));
+    return &scratch_arena;
+}
+
+void scratch_release(scratch_owner_e owner) {
+    if (scratch_owner != owner) {
+        return;
+    }
+    MEMZERO(&scratch_arena, sizeof(scratch_arena));
+    scratch_owner = scratch_owner_none;
+}
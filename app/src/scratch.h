@@ -0,0 +1,56 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include "host_build.h"
+
+#define SCRATCH_VALIDATE_KEY_LEN    40
+#define SCRATCH_VALIDATE_VAL_LEN    40
+// 5 hardened components: "2147483647'/" * 5
+#define SCRATCH_PATH_LEN            64
+
+typedef enum {
+    scratch_owner_none = 0,
+    scratch_owner_validate,     // parser_validate, while iterating over all items
+    scratch_owner_path,         // addr_getItem, while rendering the derivation path
+} scratch_owner_e;
+
+// Large temporaries that would otherwise live on the stack.
+// Only one owner may hold the arena at a time.
+typedef union {
+    struct {
+        char key[SCRATCH_VALIDATE_KEY_LEN];
+        char val[SCRATCH_VALIDATE_VAL_LEN];
+    } validate;
+    char path[SCRATCH_PATH_LEN];
+} scratch_arena_t;
+
+/// Takes ownership of the scratch arena
+/// \return the cleared arena or NULL if it is already in use
+scratch_arena_t *scratch_acquire(scratch_owner_e owner);
+
+/// Returns the scratch arena, only the current owner can release it
+void scratch_release(scratch_owner_e owner);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,90 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include "host_build.h"
+
+// Parser trace points, host builds with PARSER_TRACE only. Records go to a per
+// thread ring buffer; without PARSER_TRACE every TRACE_* macro expands to nothing.
+// host/tools/trace_decode.py decodes trace_dump files, keep its tables in sync.
+
+#if defined(PARSER_TRACE) && !defined(APP_HOST_BUILD)
+#error "PARSER_TRACE is only available on host builds"
+#endif
+
+#define TRACE_CAPACITY      1024u       // records per thread, a power of two
+#define TRACE_MAGIC         "MANTRACE"
+#define TRACE_MAGIC_LEN     8u
+#define TRACE_VERSION       1u
+
+typedef enum {
+    trace_ev_rlp_read = 1,      // offset: item start, len: payload length
+    trace_ev_read,              // offset: 0, len: buffer length
+    trace_ev_read_fields,       // len: recipients
+    trace_ev_get_item,          // offset: display index, len: page
+    trace_ev_check_error,       // offset: line, len: trace_file_e
+} trace_event_e;
+
+/// Source file of a check_error record, set with TRACE_FILE before any include
+typedef enum {
+    trace_file_other = 0,
+    trace_file_rlp,
+    trace_file_parser_impl,
+    trace_file_parser,
+} trace_file_e;
+
+typedef struct {
+    uint16_t event;
+    uint16_t error;             // parser_error_t
+    uint32_t offset;
+    uint32_t len;
+    uint32_t seq;               // per thread, wraps
+} trace_record_t;
+
+void trace_record(uint16_t event, uint32_t offset, uint32_t len, uint16_t error);
+
+/// Copies the calling thread's records, oldest first
+/// \return number of records copied
+size_t trace_snapshot(trace_record_t *records, size_t maxRecords);
+void trace_reset(void);
+
+/// Writes the calling thread's records to path: magic, version, count, records
+/// \return 0 on success
+int trace_dump(const char *path);
+
+#ifdef PARSER_TRACE
+#ifdef TRACE_FILE
+#define TRACE_FILE_ID TRACE_FILE
+#else
+#define TRACE_FILE_ID trace_file_other
+#endif
+#define TRACE_EVENT(__ev, __offset, __len, __err) \
+    trace_record((uint16_t) (__ev), (uint32_t) (__offset), (uint32_t) (__len), (uint16_t) (__err));
+#define TRACE_ERROR(__err)  TRACE_EVENT(trace_ev_check_error, __LINE__, TRACE_FILE_ID, __err)
+#else
+#define TRACE_EVENT(__ev, __offset, __len, __err)
+#define TRACE_ERROR(__err)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
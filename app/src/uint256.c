@@ -21,6 +21,7 @@
 #include <stdlib.h>
 
 #include "uint256.h"
+#include "budget.h"
 
 static const char HEXDIGITS[] = "0123456789abcdef";
 
@@ -519,16 +520,26 @@ bool tostring128(uint128_t *number, uint32_t baseParam, char *out,
     return true;
 }
 
+// Divides number in place by a small divisor and returns the remainder.
+// Works on 32-bit halves so every intermediate value fits in 64 bits.
+static uint32_t divmod256_small(uint256_t *number, uint32_t divisor) {
+    uint64_t *limbs[4] = {&UPPER(UPPER_P(number)), &LOWER(UPPER_P(number)),
+                          &UPPER(LOWER_P(number)), &LOWER(LOWER_P(number))};
+    uint64_t remainder = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        const uint64_t high = (remainder << 32) | (*limbs[i] >> 32);
+        remainder = high % divisor;
+        const uint64_t low = (remainder << 32) | (*limbs[i] & 0xFFFFFFFF);
+        remainder = low % divisor;
+        *limbs[i] = ((high / divisor) << 32) | (low / divisor);
+    }
+    return (uint32_t) remainder;
+}
+
 bool tostring256(uint256_t *number, uint32_t baseParam, char *out,
                  uint32_t outLength) {
     uint256_t rDiv;
-    uint256_t rMod;
-    uint256_t base;
     copy256(&rDiv, number);
-    clear256(&rMod);
-    clear256(&base);
-    UPPER(LOWER(base)) = 0;
-    LOWER(LOWER(base)) = baseParam;
     uint32_t offset = 0;
     if ((baseParam < 2) || (baseParam > 16)) {
         return false;
@@ -537,11 +548,10 @@ bool tostring256(uint256_t *number, uint32_t baseParam, char *out,
     outLength--;    // Keep a byte for termination
 
     do {
-        if (offset > (outLength - 1)) {
+        if (offset > (outLength - 1) || !budget_spend(budget_div_steps, 1)) {
             return false;
         }
-        divmod256(&rDiv, &base, &rDiv, &rMod);
-        out[offset++] = HEXDIGITS[(uint8_t)LOWER(LOWER(rMod))];
+        out[offset++] = HEXDIGITS[divmod256_small(&rDiv, baseParam)];
     } while (!zero256(&rDiv));
     out[offset] = '\0';
     reverseString(out, offset);
@@ -0,0 +1,257 @@
+/** Multi-buffer Keccak-256
+ *
+ * Hashes several equal-length messages at once, one message per SIMD lane.
+ * AVX-512 (8 lanes) and AVX2 (4 lanes) are selected at runtime, any remainder
+ * or unsupported CPU goes through keccak_hash.
+ *
+ * Host only, device builds hash through the SDK.
+ */
+#include "keccak.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define KECCAK_RATE         (200 - 256 / 4)
+#define KECCAK_RATE_WORDS   (KECCAK_RATE / 8)
+#define KECCAK_ROUNDS       24
+#define KECCAK_DELIM        0x01
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define KECCAK_BATCH_X86
+#include <immintrin.h>
+#endif
+
+#if defined(KECCAK_BATCH_X86)
+
+static const uint64_t RC[KECCAK_ROUNDS] = {
+    1ULL, 0x8082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+    0x808bULL, 0x80000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x8aULL, 0x88ULL, 0x80008009ULL, 0x8000000aULL,
+    0x8000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x80000001ULL, 0x8000000080008008ULL};
+
+// Rotation offsets indexed by x + 5 * y
+static const uint8_t ROT[25] = {
+     0,  1, 62, 28, 27,
+    36, 44,  6, 55, 20,
+     3, 10, 43, 25, 39,
+    41, 45, 15, 21,  8,
+    18,  2, 61, 56, 14};
+
+static uint64_t load64_le(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+// Collects block `offset` of every lane as words, word-major: words[w * lanes + lane]
+// The final block carries the padding
+static void load_block(const unsigned char *const *in, unsigned int lanes,
+                       size_t offset, size_t inLen, uint64_t *words) {
+    uint8_t block[KECCAK_RATE];
+    const size_t remaining = inLen - offset;
+    const size_t take = remaining < KECCAK_RATE ? remaining : KECCAK_RATE;
+    const int last = remaining < KECCAK_RATE;
+
+    for (unsigned int lane = 0; lane < lanes; lane++) {
+        memset(block, 0, sizeof(block));
+        if (take > 0) {
+            memcpy(block, in[lane] + offset, take);
+        }
+        if (last) {
+            block[take] ^= KECCAK_DELIM;
+            block[KECCAK_RATE - 1] ^= 0x80;
+        }
+        for (unsigned int w = 0; w < KECCAK_RATE_WORDS; w++) {
+            words[w * lanes + lane] = load64_le(block + 8 * w);
+        }
+    }
+}
+
+static void store_output(unsigned char *const *out, unsigned int lanes,
+                         const uint64_t *words, unsigned int outLen) {
+    for (unsigned int lane = 0; lane < lanes; lane++) {
+        for (unsigned int i = 0; i < outLen; i++) {
+            out[lane][i] = (uint8_t) (words[(i / 8) * lanes + lane] >> (8 * (i % 8)));
+        }
+    }
+}
+
+/******** AVX2, 4 lanes ********/
+
+__attribute__((target("avx2")))
+static __m256i rol_x4(__m256i v, uint8_t s) {
+    // Shift counts of 64 produce zero, so s == 0 is handled too
+    return _mm256_or_si256(_mm256_sll_epi64(v, _mm_cvtsi32_si128(s)),
+                           _mm256_srl_epi64(v, _mm_cvtsi32_si128(64 - s)));
+}
+
+__attribute__((target("avx2")))
+static void keccakf_x4(__m256i *a) {
+    __m256i b[25];
+    __m256i c[5];
+    __m256i d[5];
+
+    for (int round = 0; round < KECCAK_ROUNDS; round++) {
+        // Theta
+        for (int x = 0; x < 5; x++) {
+            c[x] = _mm256_xor_si256(_mm256_xor_si256(a[x], a[x + 5]),
+                                    _mm256_xor_si256(_mm256_xor_si256(a[x + 10], a[x + 15]), a[x + 20]));
+        }
+        for (int x = 0; x < 5; x++) {
+            d[x] = _mm256_xor_si256(c[(x + 4) % 5], rol_x4(c[(x + 1) % 5], 1));
+        }
+        // Rho and pi
+        for (int y = 0; y < 5; y++) {
+            for (int x = 0; x < 5; x++) {
+                b[y + 5 * ((2 * x + 3 * y) % 5)] = rol_x4(_mm256_xor_si256(a[x + 5 * y], d[x]), ROT[x + 5 * y]);
+            }
+        }
+        // Chi
+        for (int y = 0; y < 25; y += 5) {
+            for (int x = 0; x < 5; x++) {
+                a[y + x] = _mm256_xor_si256(b[y + x], _mm256_andnot_si256(b[y + (x + 1) % 5], b[y + (x + 2) % 5]));
+            }
+        }
+        // Iota
+        a[0] = _mm256_xor_si256(a[0], _mm256_set1_epi64x((long long) RC[round]));
+    }
+}
+
+__attribute__((target("avx2")))
+static void keccak_hash_x4(const unsigned char *const *in, unsigned int inLen,
+                           unsigned char *const *out, unsigned int outLen) {
+    __m256i a[25];
+    uint64_t words[KECCAK_RATE_WORDS * 4];
+
+    for (int i = 0; i < 25; i++) {
+        a[i] = _mm256_setzero_si256();
+    }
+
+    // There is always a final, padded block
+    for (size_t offset = 0; offset <= inLen; offset += KECCAK_RATE) {
+        load_block(in, 4, offset, inLen, words);
+        for (int w = 0; w < KECCAK_RATE_WORDS; w++) {
+            a[w] = _mm256_xor_si256(a[w], _mm256_loadu_si256((const __m256i *) (words + 4 * w)));
+        }
+        keccakf_x4(a);
+    }
+
+    for (int w = 0; w < KECCAK_RATE_WORDS; w++) {
+        _mm256_storeu_si256((__m256i *) (words + 4 * w), a[w]);
+    }
+    store_output(out, 4, words, outLen);
+}
+
+/******** AVX-512, 8 lanes ********/
+
+__attribute__((target("avx512f")))
+static void keccakf_x8(__m512i *a) {
+    __m512i b[25];
+    __m512i c[5];
+    __m512i d[5];
+
+    for (int round = 0; round < KECCAK_ROUNDS; round++) {
+        // Theta
+        for (int x = 0; x < 5; x++) {
+            // 0x96: three-way xor
+            c[x] = _mm512_ternarylogic_epi64(a[x], a[x + 5], a[x + 10], 0x96);
+            c[x] = _mm512_ternarylogic_epi64(c[x], a[x + 15], a[x + 20], 0x96);
+        }
+        for (int x = 0; x < 5; x++) {
+            d[x] = _mm512_xor_si512(c[(x + 4) % 5], _mm512_rol_epi64(c[(x + 1) % 5], 1));
+        }
+        // Rho and pi
+        for (int y = 0; y < 5; y++) {
+            for (int x = 0; x < 5; x++) {
+                b[y + 5 * ((2 * x + 3 * y) % 5)] = _mm512_rolv_epi64(_mm512_xor_si512(a[x + 5 * y], d[x]),
+                                                                     _mm512_set1_epi64(ROT[x + 5 * y]));
+            }
+        }
+        // Chi, 0xD2: a ^ (~b & c)
+        for (int y = 0; y < 25; y += 5) {
+            for (int x = 0; x < 5; x++) {
+                a[y + x] = _mm512_ternarylogic_epi64(b[y + x], b[y + (x + 1) % 5], b[y + (x + 2) % 5], 0xD2);
+            }
+        }
+        // Iota
+        a[0] = _mm512_xor_si512(a[0], _mm512_set1_epi64((long long) RC[round]));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void keccak_hash_x8(const unsigned char *const *in, unsigned int inLen,
+                           unsigned char *const *out, unsigned int outLen) {
+    __m512i a[25];
+    uint64_t words[KECCAK_RATE_WORDS * 8];
+
+    for (int i = 0; i < 25; i++) {
+        a[i] = _mm512_setzero_si512();
+    }
+
+    // There is always a final, padded block
+    for (size_t offset = 0; offset <= inLen; offset += KECCAK_RATE) {
+        load_block(in, 8, offset, inLen, words);
+        for (int w = 0; w < KECCAK_RATE_WORDS; w++) {
+            a[w] = _mm512_xor_si512(a[w], _mm512_loadu_si512((const void *) (words + 8 * w)));
+        }
+        keccakf_x8(a);
+    }
+
+    for (int w = 0; w < KECCAK_RATE_WORDS; w++) {
+        _mm512_storeu_si512((void *) (words + 8 * w), a[w]);
+    }
+    store_output(out, 8, words, outLen);
+}
+
+#endif
+
+unsigned int keccak_batch_lanes() {
+#if defined(KECCAK_BATCH_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return 8;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return 4;
+    }
+#endif
+    return 1;
+}
+
+zxerr_t keccak_hash_batch(const unsigned char *const *in, unsigned int inLen,
+                          unsigned char *const *out, unsigned int outLen,
+                          unsigned int count) {
+    if (in == NULL || out == NULL || outLen > KECCAK_RATE) {
+        return zxerr_invalid_crypto_settings;
+    }
+    for (unsigned int i = 0; i < count; i++) {
+        if (out[i] == NULL || (in[i] == NULL && inLen != 0)) {
+            return zxerr_invalid_crypto_settings;
+        }
+    }
+
+    unsigned int done = 0;
+#if defined(KECCAK_BATCH_X86)
+    const unsigned int lanes = keccak_batch_lanes();
+    for (; lanes >= 8 && count - done >= 8; done += 8) {
+        keccak_hash_x8(in + done, inLen, out + done, outLen);
+    }
+    for (; lanes >= 4 && count - done >= 4; done += 4) {
+        keccak_hash_x4(in + done, inLen, out + done, outLen);
+    }
+#endif
+
+    // Remainder and scalar fallback
+    for (; done < count; done++) {
+        const zxerr_t err = keccak_hash(in[done], inLen, out[done], outLen);
+        if (err != zxerr_ok) {
+            return err;
+        }
+    }
+
+    return zxerr_ok;
+}
@@ -16,6 +16,26 @@ extern "C" {
 zxerr_t keccak_hash(const unsigned char *in, unsigned int inLen,
                     unsigned char *out, unsigned int outLen);
 
+// Streaming variant (keccak-stream.c): the state absorbs input as it arrives
+typedef struct {
+    uint64_t a[25];
+    size_t pos;         // bytes absorbed into the current block
+} keccak_ctx_t;
+
+zxerr_t keccak_init(keccak_ctx_t *ctx);
+zxerr_t keccak_update(keccak_ctx_t *ctx, const unsigned char *in, size_t inLen);
+// Writes the digest and clears the context
+zxerr_t keccak_final(keccak_ctx_t *ctx, unsigned char *out, unsigned int outLen);
+
+// Multi-buffer variant (keccak-batch.c): hashes `count` messages of the same length.
+// outLen is limited to the rate (136 bytes).
+zxerr_t keccak_hash_batch(const unsigned char *const *in, unsigned int inLen,
+                          unsigned char *const *out, unsigned int outLen,
+                          unsigned int count);
+
+// Number of messages hashed in parallel on this CPU (8, 4 or 1)
+unsigned int keccak_batch_lanes();
+
 #ifdef __cplusplus
 }
 #endif
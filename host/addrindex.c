@@ -0,0 +1,423 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "addrindex.h"
+#include "crypto_helper.h"
+#include "rlp.h"
+#include "zxmacros.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(addrindex_header_t) == ADDRINDEX_BLOCK_LEN, "addrindex header layout");
+
+#define ADDRINDEX_SEED          0x4d414e2e41444452ull
+#define ADDRINDEX_BLOOM_WORDS   (ADDRINDEX_BLOCK_LEN / sizeof(uint64_t))
+// At least 16 filter bits per address, one bit in each word of the block: well under 1% false positives
+#define ADDRINDEX_PER_BLOCK     32u
+// Tables are at most 7/8 full
+#define ADDRINDEX_MAX_COUNT     (1ull << 40u)
+
+#define BYTES_01    0x0101010101010101ull
+#define BYTES_80    0x8080808080808080ull
+
+static uint64_t mix(uint64_t x) {
+    x ^= x >> 30u;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27u;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31u;
+    return x;
+}
+
+static uint64_t hashAddress(const uint8_t *address, uint64_t seed) {
+    uint64_t w0, w1;
+    uint32_t w2;
+    memcpy(&w0, address, sizeof(w0));
+    memcpy(&w1, address + 8, sizeof(w1));
+    memcpy(&w2, address + 16, sizeof(w2));
+    return mix(mix(mix(seed ^ w0) ^ w1) ^ w2);
+}
+
+static uint64_t nextPow2(uint64_t v) {
+    uint64_t p = 1;
+    while (p < v) {
+        p <<= 1u;
+    }
+    return p;
+}
+
+// Low hash bits pick the group, the top 7 are the control tag, bits 32.. the filter block
+static uint8_t tagOf(uint64_t h) {
+    return (uint8_t) (h >> 57u);
+}
+
+static const uint64_t *bloomBlock(const uint64_t *bloom, uint32_t blocks, uint64_t h) {
+    return bloom + ((h >> 32u) & (blocks - 1)) * ADDRINDEX_BLOOM_WORDS;
+}
+
+static bool bloomMayContain(const uint64_t *bloom, uint32_t blocks, uint64_t h) {
+    const uint64_t *block = bloomBlock(bloom, blocks, h);
+    const uint64_t bits = mix(h);
+    uint64_t missing = 0;
+    for (uint8_t i = 0; i < ADDRINDEX_BLOOM_WORDS; i++) {
+        missing |= ~block[i] & (1ull << ((bits >> (6 * i)) & 63u));
+    }
+    return missing == 0;
+}
+
+static void bloomAdd(uint64_t *bloom, uint32_t blocks, uint64_t h) {
+    uint64_t *block = (uint64_t *) bloomBlock(bloom, blocks, h);
+    const uint64_t bits = mix(h);
+    for (uint8_t i = 0; i < ADDRINDEX_BLOOM_WORDS; i++) {
+        block[i] |= 1ull << ((bits >> (6 * i)) & 63u);
+    }
+}
+
+// Bytes of word equal to tag have their top bit set. Borrows can flag a byte above
+// a real match too, candidates are always confirmed against the address.
+static uint64_t matchTag(uint64_t word, uint8_t tag) {
+    const uint64_t x = word ^ (BYTES_01 * tag);
+    return (x - BYTES_01) & ~x & BYTES_80;
+}
+
+// Triangular probing visits every group once when their number is a power of two
+static uint64_t probeGroup(uint64_t h, uint64_t step, uint64_t groups) {
+    return (h + step * (step + 1) / 2) & (groups - 1);
+}
+
+static bool tableFind(const uint8_t *control, const uint8_t *addresses, uint64_t groups,
+                      uint64_t h, const uint8_t *address, uint64_t *freeSlot) {
+    const uint8_t tag = tagOf(h);
+    for (uint64_t step = 0; step < groups; step++) {
+        const uint64_t group = probeGroup(h, step, groups);
+        const uint8_t *ctrl = control + group * ADDRINDEX_GROUP;
+        uint64_t word;
+        memcpy(&word, ctrl, sizeof(word));
+
+        if (matchTag(word, tag) != 0) {
+            for (uint8_t i = 0; i < ADDRINDEX_GROUP; i++) {
+                const uint64_t slot = group * ADDRINDEX_GROUP + i;
+                if (ctrl[i] == tag && memcmp(addresses + slot * ETH_ADDRESS_LEN, address, ETH_ADDRESS_LEN) == 0) {
+                    return true;
+                }
+            }
+        }
+        // Nothing is ever removed: an empty slot ends the probe
+        if ((word & BYTES_80) != 0) {
+            if (freeSlot != NULL) {
+                uint8_t i = 0;
+                while (ctrl[i] != ADDRINDEX_EMPTY) {
+                    i++;
+                }
+                *freeSlot = group * ADDRINDEX_GROUP + i;
+            }
+            return false;
+        }
+    }
+    return false;
+}
+
+zxerr_t addrindex_build(const uint8_t (*addresses)[ETH_ADDRESS_LEN], uint64_t count,
+                        uint8_t **image, size_t *imageLen) {
+    if ((addresses == NULL && count > 0) || image == NULL || imageLen == NULL || count > ADDRINDEX_MAX_COUNT) {
+        return zxerr_unknown;
+    }
+
+    const uint64_t blocks = nextPow2((count + ADDRINDEX_PER_BLOCK - 1) / ADDRINDEX_PER_BLOCK);
+    const uint64_t groups = nextPow2((count * 8 / 7 + ADDRINDEX_GROUP) / ADDRINDEX_GROUP);
+    if (blocks > UINT32_MAX) {
+        return zxerr_unknown;
+    }
+    const size_t bloomLen = (size_t) blocks * ADDRINDEX_BLOCK_LEN;
+    const size_t controlLen = (size_t) groups * ADDRINDEX_GROUP;
+    const size_t len = sizeof(addrindex_header_t) + bloomLen + controlLen + controlLen * ETH_ADDRESS_LEN;
+
+    uint8_t *buffer = calloc(1, len);
+    if (buffer == NULL) {
+        return zxerr_buffer_too_small;
+    }
+    addrindex_header_t *header = (addrindex_header_t *) buffer;
+    uint64_t *bloom = (uint64_t *) (header + 1);
+    uint8_t *control = (uint8_t *) bloom + bloomLen;
+    uint8_t *slots = control + controlLen;
+    memset(control, ADDRINDEX_EMPTY, controlLen);
+
+    uint64_t stored = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        const uint64_t h = hashAddress(addresses[i], ADDRINDEX_SEED);
+        uint64_t slot = 0;
+        if (tableFind(control, slots, groups, h, addresses[i], &slot)) {
+            continue;
+        }
+        control[slot] = tagOf(h);
+        memcpy(slots + slot * ETH_ADDRESS_LEN, addresses[i], ETH_ADDRESS_LEN);
+        bloomAdd(bloom, (uint32_t) blocks, h);
+        stored++;
+    }
+
+    memcpy(header->magic, ADDRINDEX_MAGIC, ADDRINDEX_MAGIC_LEN);
+    header->version = ADDRINDEX_VERSION;
+    header->bloomBlocks = (uint32_t) blocks;
+    header->seed = ADDRINDEX_SEED;
+    header->groups = groups;
+    header->count = stored;
+
+    *image = buffer;
+    *imageLen = len;
+    return zxerr_ok;
+}
+
+static size_t trimLine(char *line, size_t len) {
+    size_t start = 0;
+    while (start < len && (line[start] == ' ' || line[start] == '\t')) {
+        start++;
+    }
+    while (len > start && (line[len - 1] == '\n' || line[len - 1] == '\r' ||
+                           line[len - 1] == ' ' || line[len - 1] == '\t')) {
+        len--;
+    }
+    memmove(line, line + start, len - start);
+    return len - start;
+}
+
+static zxerr_t readList(FILE *f, uint8_t (**addresses)[ETH_ADDRESS_LEN], uint64_t *count, uint64_t *errorLine) {
+    char *line = NULL;
+    size_t lineCap = 0;
+    ssize_t read;
+    uint64_t capacity = 0;
+    uint64_t lineNumber = 0;
+    zxerr_t err = zxerr_ok;
+
+    while ((read = getline(&line, &lineCap, f)) >= 0) {
+        lineNumber++;
+        const size_t len = trimLine(line, (size_t) read);
+        if (len == 0 || line[0] == '#') {
+            continue;
+        }
+
+        if (*count == capacity) {
+            capacity = capacity == 0 ? 1024 : capacity * 2;
+            uint8_t (*grown)[ETH_ADDRESS_LEN] = realloc(*addresses, capacity * ETH_ADDRESS_LEN);
+            if (grown == NULL) {
+                err = zxerr_buffer_too_small;
+                break;
+            }
+            *addresses = grown;
+        }
+        if (len > UINT16_MAX || crypto_decodeManAddress((const uint8_t *) line, (uint16_t) len, (*addresses)[*count]) != zxerr_ok) {
+            if (errorLine != NULL) {
+                *errorLine = lineNumber;
+            }
+            err = zxerr_encoding_failed;
+            break;
+        }
+        (*count)++;
+    }
+    free(line);
+    return err;
+}
+
+zxerr_t addrindex_buildFile(const char *listPath, const char *indexPath, uint64_t *count, uint64_t *errorLine) {
+    if (listPath == NULL || indexPath == NULL) {
+        return zxerr_unknown;
+    }
+
+    FILE *list = fopen(listPath, "r");
+    if (list == NULL) {
+        return zxerr_no_data;
+    }
+    uint8_t (*addresses)[ETH_ADDRESS_LEN] = NULL;
+    uint64_t listed = 0;
+    zxerr_t err = readList(list, &addresses, &listed, errorLine);
+    fclose(list);
+
+    uint8_t *image = NULL;
+    size_t imageLen = 0;
+    if (err == zxerr_ok) {
+        err = addrindex_build((const uint8_t (*)[ETH_ADDRESS_LEN]) addresses, listed, &image, &imageLen);
+    }
+    free(addresses);
+
+    if (err == zxerr_ok) {
+        FILE *f = fopen(indexPath, "wb");
+        bool ok = f != NULL && fwrite(image, imageLen, 1, f) == 1;
+        ok = (f != NULL && fclose(f) == 0) && ok;
+        err = ok ? zxerr_ok : zxerr_unknown;
+        if (ok && count != NULL) {
+            *count = ((const addrindex_header_t *) image)->count;
+        }
+    }
+    free(image);
+    return err;
+}
+
+zxerr_t addrindex_view(addrindex_t *index, const uint8_t *image, size_t imageLen) {
+    if (index == NULL || image == NULL) {
+        return zxerr_unknown;
+    }
+    MEMZERO(index, sizeof(*index));
+    if (imageLen < sizeof(addrindex_header_t) || ((uintptr_t) image % sizeof(uint64_t)) != 0) {
+        return zxerr_encoding_failed;
+    }
+
+    const addrindex_header_t *header = (const addrindex_header_t *) image;
+    const uint64_t blocks = header->bloomBlocks;
+    const uint64_t groups = header->groups;
+    if (memcmp(header->magic, ADDRINDEX_MAGIC, ADDRINDEX_MAGIC_LEN) != 0 ||
+        header->version != ADDRINDEX_VERSION ||
+        blocks == 0 || (blocks & (blocks - 1)) != 0 ||
+        groups == 0 || (groups & (groups - 1)) != 0 || groups > ADDRINDEX_MAX_COUNT ||
+        header->count > groups * ADDRINDEX_GROUP) {
+        return zxerr_encoding_failed;
+    }
+    const uint64_t expected = sizeof(addrindex_header_t) + blocks * ADDRINDEX_BLOCK_LEN +
+                              groups * ADDRINDEX_GROUP * (1 + ETH_ADDRESS_LEN);
+    if (expected != (uint64_t) imageLen) {
+        return zxerr_encoding_failed;
+    }
+
+    index->header = header;
+    index->bloom = (const uint64_t *) (header + 1);
+    index->control = (const uint8_t *) index->bloom + blocks * ADDRINDEX_BLOCK_LEN;
+    index->addresses = index->control + groups * ADDRINDEX_GROUP;
+    index->count = header->count;
+    return zxerr_ok;
+}
+
+zxerr_t addrindex_open(addrindex_t *index, const char *path) {
+    if (index == NULL || path == NULL) {
+        return zxerr_unknown;
+    }
+    MEMZERO(index, sizeof(*index));
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return zxerr_no_data;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(addrindex_header_t)) {
+        close(fd);
+        return zxerr_no_data;
+    }
+    void *map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return zxerr_unknown;
+    }
+
+    const zxerr_t err = addrindex_view(index, (const uint8_t *) map, (size_t) st.st_size);
+    if (err != zxerr_ok) {
+        munmap(map, (size_t) st.st_size);
+        return err;
+    }
+    index->map = map;
+    index->mapLen = (size_t) st.st_size;
+    return zxerr_ok;
+}
+
+void addrindex_close(addrindex_t *index) {
+    if (index == NULL) {
+        return;
+    }
+    if (index->map != NULL) {
+        munmap(index->map, index->mapLen);
+    }
+    MEMZERO(index, sizeof(*index));
+}
+
+bool addrindex_contains(const addrindex_t *index, const uint8_t address[ETH_ADDRESS_LEN]) {
+    if (index == NULL || index->header == NULL || address == NULL) {
+        return false;
+    }
+    const uint64_t h = hashAddress(address, index->header->seed);
+    if (!bloomMayContain(index->bloom, index->header->bloomBlocks, h)) {
+        return false;
+    }
+    return tableFind(index->control, index->addresses, index->header->groups, h, address, NULL);
+}
+
+parser_error_t addrindex_containsRlp(const addrindex_t *index, const rlp_t *address, bool *found) {
+    if (index == NULL || address == NULL || found == NULL) {
+        return parser_unexpected_error;
+    }
+    *found = false;
+    if (address->kind == RLP_KIND_STRING && address->rlpLen == 0) {
+        return parser_ok;
+    }
+
+    uint8_t decoded[ETH_ADDRESS_LEN];
+    if (address->kind != RLP_KIND_STRING || address->rlpLen > UINT8_MAX ||
+        crypto_decodeManAddress(address->ptr, (uint16_t) address->rlpLen, decoded) != zxerr_ok) {
+        return parser_invalid_address;
+    }
+    *found = addrindex_contains(index, decoded);
+    return parser_ok;
+}
+
+// Walks To and every To [i], stops at the first address whose lookup gives stopOn.
+// An empty To (contract creation) has no address, it is skipped.
+static parser_error_t walkTx(const addrindex_t *index, const parser_tx_t *tx, bool stopOn,
+                             bool *stopped, uint8_t *recipient) {
+    if (index == NULL || tx == NULL) {
+        return parser_unexpected_error;
+    }
+    bool found = false;
+    *stopped = false;
+    *recipient = ADDRINDEX_MATCH_TO;
+
+    const rlp_t *to = &tx->fields[MANTX_FIELD_TO];
+    if (to->kind != RLP_KIND_STRING || to->rlpLen != 0) {
+        CHECK_ERROR(addrindex_containsRlp(index, to, &found))
+        *stopped = found == stopOn;
+    }
+    for (uint16_t i = 0; i < tx->extraToFieldsItems && !*stopped; i++) {
+        rlp_t items[MANTX_EXTRATOFIELD_COUNT];
+        uint16_t itemCount = 0;
+        CHECK_ERROR(rlp_readList(&tx->extraToListFields[i], items, &itemCount, MANTX_EXTRATOFIELD_COUNT))
+        if (itemCount != MANTX_EXTRATOFIELD_COUNT) {
+            return parser_unexpected_number_items;
+        }
+        CHECK_ERROR(addrindex_containsRlp(index, &items[0], &found))
+        *stopped = found == stopOn;
+        if (*stopped) {
+            *recipient = (uint8_t) i;
+        }
+    }
+    return parser_ok;
+}
+
+parser_error_t addrindex_matchTx(const addrindex_t *index, const parser_tx_t *tx, addrindex_match_t *match) {
+    if (match == NULL) {
+        return parser_unexpected_error;
+    }
+    match->found = false;
+    match->recipient = ADDRINDEX_MATCH_TO;
+    return walkTx(index, tx, true, &match->found, &match->recipient);
+}
+
+parser_error_t addrindex_allListedTx(const addrindex_t *index, const parser_tx_t *tx, addrindex_match_t *missing) {
+    if (missing == NULL) {
+        return parser_unexpected_error;
+    }
+    missing->found = false;
+    missing->recipient = ADDRINDEX_MATCH_TO;
+    return walkTx(index, tx, false, &missing->found, &missing->recipient);
+}
@@ -0,0 +1,109 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "coin.h"
+#include "parser_common.h"
+#include "parser_txdef.h"
+#include "zxerror.h"
+
+// Host only: address set for allow and deny lists. Stores the decoded 20-byte
+// addresses, not the MAN strings. Most lookups are misses, so a blocked Bloom
+// filter (one cache line per address) answers them before the hash table is
+// touched. The table is open addressed: groups of 8 control bytes, each holding
+// 7 bits of the hash or ADDRINDEX_EMPTY, with the addresses in a parallel array.
+//
+// File layout, mapped as is (host byte order, little endian in practice):
+//   addrindex_header_t
+//   bloom      bloomBlocks * ADDRINDEX_BLOCK_LEN bytes
+//   control    groups * ADDRINDEX_GROUP bytes
+//   addresses  groups * ADDRINDEX_GROUP * ETH_ADDRESS_LEN bytes
+
+#define ADDRINDEX_MAGIC         "MANADDRS"
+#define ADDRINDEX_MAGIC_LEN     8u
+#define ADDRINDEX_VERSION       1u
+#define ADDRINDEX_BLOCK_LEN     64u
+#define ADDRINDEX_GROUP         8u
+#define ADDRINDEX_EMPTY         0x80u
+
+/// addrindex_match_t.recipient when the root To field matched
+#define ADDRINDEX_MATCH_TO      0xFFu
+
+typedef struct {
+    char magic[ADDRINDEX_MAGIC_LEN];
+    uint32_t version;
+    uint32_t bloomBlocks;           // a power of two
+    uint64_t seed;
+    uint64_t groups;                // a power of two
+    uint64_t count;
+    uint8_t reserved[24];           // keeps the filter cache line aligned
+} addrindex_header_t;
+
+/// Read only view over an index image, mapped or in memory
+typedef struct {
+    const addrindex_header_t *header;
+    const uint64_t *bloom;
+    const uint8_t *control;
+    const uint8_t *addresses;
+    uint64_t count;
+    void *map;
+    size_t mapLen;
+} addrindex_t;
+
+typedef struct {
+    bool found;
+    uint8_t recipient;              // ADDRINDEX_MATCH_TO or the To [i] index
+} addrindex_match_t;
+
+/// Builds an index image, duplicates are stored once. Free *image with free().
+zxerr_t addrindex_build(const uint8_t (*addresses)[ETH_ADDRESS_LEN], uint64_t count,
+                        uint8_t **image, size_t *imageLen);
+
+/// Builds the index file for a list of MAN addresses, one per line. Blank lines
+/// and lines starting with '#' are skipped.
+/// \param errorLine optional, the first line that is not a valid address
+zxerr_t addrindex_buildFile(const char *listPath, const char *indexPath, uint64_t *count, uint64_t *errorLine);
+
+/// Checks and wraps an image, it must outlive the view
+zxerr_t addrindex_view(addrindex_t *index, const uint8_t *image, size_t imageLen);
+
+/// Maps path read only, rejects anything addrindex_view rejects
+zxerr_t addrindex_open(addrindex_t *index, const char *path);
+void addrindex_close(addrindex_t *index);
+
+bool addrindex_contains(const addrindex_t *index, const uint8_t address[ETH_ADDRESS_LEN]);
+
+/// Decodes a MAN address span in place, an empty one (contract creation) is never found
+parser_error_t addrindex_containsRlp(const addrindex_t *index, const rlp_t *address, bool *found);
+
+/// Deny lists: looks up To and every To [i] of a transaction read by _read, stops at the first match
+parser_error_t addrindex_matchTx(const addrindex_t *index, const parser_tx_t *tx, addrindex_match_t *match);
+
+/// Allow lists: the transaction passes only if To and every To [i] are listed, so
+/// missing->found is false. Otherwise missing names the first address that is not,
+/// an empty To (contract creation) never is.
+parser_error_t addrindex_allListedTx(const addrindex_t *index, const parser_tx_t *tx, addrindex_match_t *missing);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,130 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "columnar.h"
+#include "crypto_helper.h"
+#include "parser_impl.h"
+#include "rlp.h"
+
+static parser_error_t readUInt64(const rlp_t *rlp, uint64_t *value, uint8_t *wide, uint8_t wideBit) {
+    uint256_t tmp;
+    CHECK_ERROR(rlp_readUInt256(rlp, &tmp))
+    if (!zero128(&UPPER(tmp)) || UPPER(LOWER(tmp)) != 0) {
+        *value = UINT64_MAX;
+        *wide |= wideBit;
+        return parser_ok;
+    }
+    *value = LOWER(LOWER(tmp));
+    return parser_ok;
+}
+
+static parser_error_t readAddress(const rlp_t *rlp, uint8_t *address) {
+    if (rlp->rlpLen == 0) {
+        return parser_ok;
+    }
+    // Already validated by _read
+    if (crypto_decodeManAddress(rlp->ptr, (uint16_t) rlp->rlpLen, address) != zxerr_ok) {
+        return parser_invalid_address;
+    }
+    return parser_ok;
+}
+
+static parser_error_t fillRow(mantx_columns_t *cols, uint32_t row, const parser_tx_t *tx) {
+    uint8_t *wide = &cols->wide[row];
+    CHECK_ERROR(readUInt64(&tx->fields[MANTX_FIELD_NONCE], &cols->nonce[row], wide, COLUMNAR_WIDE_NONCE))
+    CHECK_ERROR(readUInt64(&tx->fields[MANTX_FIELD_GASPRICE], &cols->gasPrice[row], wide, COLUMNAR_WIDE_GASPRICE))
+    CHECK_ERROR(readUInt64(&tx->fields[MANTX_FIELD_GASLIMIT], &cols->gasLimit[row], wide, COLUMNAR_WIDE_GASLIMIT))
+    CHECK_ERROR(readAddress(&tx->fields[MANTX_FIELD_TO], cols->to[row]))
+    CHECK_ERROR(rlp_readUInt256(&tx->fields[MANTX_FIELD_VALUE], &cols->value[row]))
+    CHECK_ERROR(readUInt64(&tx->fields[MANTX_ROOT_COMMITTIME], &cols->commitTime[row], wide, COLUMNAR_WIDE_COMMITTIME))
+    cols->txType[row] = tx->extraTxType;
+
+    for (uint16_t i = 0; i < tx->extraToFieldsItems; i++) {
+        const uint32_t r = cols->recipients + i;
+        rlp_t recipient[MANTX_EXTRATOFIELD_COUNT];
+        uint16_t items = 0;
+        CHECK_ERROR(rlp_readList(&tx->extraToListFields[i], recipient, &items, MANTX_EXTRATOFIELD_COUNT))
+        MEMZERO(cols->recipientTo[r], ETH_ADDRESS_LEN);
+        CHECK_ERROR(readAddress(&recipient[0], cols->recipientTo[r]))
+        CHECK_ERROR(rlp_readUInt256(&recipient[1], &cols->recipientAmount[r]))
+    }
+    return parser_ok;
+}
+
+static void clearRow(mantx_columns_t *cols, uint32_t row) {
+    cols->nonce[row] = 0;
+    cols->gasPrice[row] = 0;
+    cols->gasLimit[row] = 0;
+    MEMZERO(cols->to[row], ETH_ADDRESS_LEN);
+    clear256(&cols->value[row]);
+    cols->txType[row] = 0;
+    cols->commitTime[row] = 0;
+    cols->wide[row] = 0;
+}
+
+void mantx_columns_reset(mantx_columns_t *cols) {
+    if (cols == NULL) {
+        return;
+    }
+    cols->rows = 0;
+    cols->recipients = 0;
+    cols->recipientOffsets[0] = 0;
+}
+
+zxerr_t mantx_columns_append(mantx_columns_t *cols, const uint8_t *blob, uint16_t blobLen) {
+    if (cols == NULL || blob == NULL) {
+        return zxerr_no_data;
+    }
+    if (cols->rows == cols->capacity) {
+        return zxerr_buffer_too_small;
+    }
+
+    const uint32_t row = cols->rows;
+    clearRow(cols, row);
+
+    // Validation goes through _read, nothing but the columns outlives the call
+    parser_tx_t tx;
+    parser_context_t ctx = {.buffer = blob, .bufferLen = blobLen, .offset = 0, .tx_obj = &tx};
+    parser_error_t err = _read(&ctx, &tx);
+    if (err == parser_ok) {
+        if (cols->recipientCapacity - cols->recipients < tx.extraToFieldsItems) {
+            return zxerr_buffer_too_small;
+        }
+        err = fillRow(cols, row, &tx);
+    }
+
+    if (err == parser_ok) {
+        cols->recipients += tx.extraToFieldsItems;
+    } else {
+        clearRow(cols, row);
+    }
+    cols->status[row] = (uint8_t) err;
+    cols->recipientOffsets[row + 1] = cols->recipients;
+    cols->rows++;
+    return zxerr_ok;
+}
+
+uint32_t mantx_columns_decode(mantx_columns_t *cols, const uint8_t *const *blobs, const uint16_t *blobLens,
+                              uint32_t count) {
+    if (cols == NULL || blobs == NULL || blobLens == NULL) {
+        return 0;
+    }
+
+    uint32_t added = 0;
+    while (added < count && mantx_columns_append(cols, blobs[added], blobLens[added]) == zxerr_ok) {
+        added++;
+    }
+    return added;
+}
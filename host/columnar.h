@@ -0,0 +1,77 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "coin.h"
+#include "parser_common.h"
+#include "uint256.h"
+#include "zxerror.h"
+
+// Host only: batch decode of MAN transactions into columns (struct of arrays).
+// Every array is owned by the caller. Rows that fail to parse keep their status
+// and zeros in every other column, so all columns stay aligned.
+
+// Nonce, GasPrice, GasLimit and CommitTime are stored as uint64_t although the
+// parser accepts up to 256 bits. A wider value saturates to UINT64_MAX and sets
+// its bit in the wide column; the row stays valid and the blob has the full value.
+#define COLUMNAR_WIDE_NONCE         0x01u
+#define COLUMNAR_WIDE_GASPRICE      0x02u
+#define COLUMNAR_WIDE_GASLIMIT      0x04u
+#define COLUMNAR_WIDE_COMMITTIME    0x08u
+
+typedef struct {
+    // Transaction columns, `capacity` rows each
+    uint32_t capacity;
+    uint32_t rows;
+    uint8_t *status;                            // parser_error_t of the row
+    uint64_t *nonce;
+    uint64_t *gasPrice;
+    uint64_t *gasLimit;
+    uint8_t (*to)[ETH_ADDRESS_LEN];             // zeros for contract creation
+    uint256_t *value;
+    uint8_t *txType;
+    uint64_t *commitTime;
+    uint8_t *wide;                              // COLUMNAR_WIDE_* bits
+    // capacity + 1 entries: the recipients of row i are [recipientOffsets[i], recipientOffsets[i + 1])
+    uint32_t *recipientOffsets;
+
+    // Recipient columns, `recipientCapacity` rows each
+    uint32_t recipientCapacity;
+    uint32_t recipients;
+    uint8_t (*recipientTo)[ETH_ADDRESS_LEN];
+    uint256_t *recipientAmount;
+} mantx_columns_t;
+
+/// Drops every row, the arrays are reused
+void mantx_columns_reset(mantx_columns_t *cols);
+
+/// Decodes one transaction into a new row
+/// \return zxerr_ok once the row is added (its own result is in status),
+///         zxerr_buffer_too_small when either set of columns is full (nothing is added)
+zxerr_t mantx_columns_append(mantx_columns_t *cols, const uint8_t *blob, uint16_t blobLen);
+
+/// Appends `count` transactions, stopping early when the columns are full
+/// \return number of rows added
+uint32_t mantx_columns_decode(mantx_columns_t *cols, const uint8_t *const *blobs, const uint16_t *blobLens,
+                              uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,39 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "hex.h"
+
+static int8_t hexNibble(char c) {
+    if (c >= '0' && c <= '9') return (int8_t) (c - '0');
+    if (c >= 'a' && c <= 'f') return (int8_t) (c - 'a' + 10);
+    if (c >= 'A' && c <= 'F') return (int8_t) (c - 'A' + 10);
+    return -1;
+}
+
+bool hex_decode(const char *hex, size_t hexLen, uint8_t *out, size_t outMax, size_t *outLen) {
+    if (hex == NULL || out == NULL || outLen == NULL || hexLen % 2 != 0 || hexLen / 2 > outMax) {
+        return false;
+    }
+    for (size_t i = 0; i < hexLen / 2; i++) {
+        const int8_t hi = hexNibble(hex[2 * i]);
+        const int8_t lo = hexNibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        out[i] = (uint8_t) ((hi << 4) | lo);
+    }
+    *outLen = hexLen / 2;
+    return true;
+}
@@ -0,0 +1,36 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// zxlib's parseHexString reads a NUL-terminated string with a uint16_t output length.
+// Host callers decode spans of mmap'd input files, which are not terminated and can
+// be longer, so this decoder takes an explicit length on both sides.
+
+/// Decodes hexLen hex digits, either case, into out
+/// \return false on an odd length, a non hex digit or if out holds less than hexLen / 2 bytes
+bool hex_decode(const char *hex, size_t hexLen, uint8_t *out, size_t outMax, size_t *outLen);
+
+#ifdef __cplusplus
+}
+#endif
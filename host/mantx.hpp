@@ -0,0 +1,311 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+// Host only, header only C++11 facade over the parser.
+// Every accessor returns a view into the caller's buffer, amounts are decoded and
+// formatted on demand and display pages render into buffers held by the iterator.
+// Nothing allocates: a transaction and its iterators can live on the stack.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#include "parser.h"
+#include "rlp.h"
+#include "uint256.h"
+
+namespace mantx {
+
+/// Non owning view over bytes
+class bytes_view {
+public:
+    bytes_view() = default;
+    bytes_view(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+    const uint8_t *data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const uint8_t *begin() const { return data_; }
+    const uint8_t *end() const { return data_ + size_; }
+    uint8_t operator[](size_t i) const { return data_[i]; }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/// Non owning view over characters, not zero terminated
+class text_view {
+public:
+    text_view() = default;
+    text_view(const char *data, size_t size) : data_(data), size_(size) {}
+    explicit text_view(const char *str) : data_(str), size_(str != nullptr ? strlen(str) : 0) {}
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const char *begin() const { return data_; }
+    const char *end() const { return data_ + size_; }
+
+    bool operator==(const text_view &other) const {
+        return size_ == other.size_ && (size_ == 0 || memcmp(data_, other.data_, size_) == 0);
+    }
+    bool operator!=(const text_view &other) const { return !(*this == other); }
+
+private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/// Integer field, decoded only when asked for
+class amount {
+public:
+    amount() = default;
+    explicit amount(const rlp_t &rlp) : rlp_(rlp), valid_(true) {}
+
+    parser_error_t get(uint256_t *value) const {
+        if (!valid_) {
+            return parser_no_data;
+        }
+        return rlp_readUInt256(&rlp_, value);
+    }
+
+    /// Decimal, zero terminated into out
+    parser_error_t format(char *out, uint16_t outLen) const {
+        uint256_t value;
+        CHECK_ERROR(get(&value))
+        return tostring256(&value, 10, out, outLen) ? parser_ok : parser_unexpected_buffer_end;
+    }
+
+private:
+    rlp_t rlp_{};
+    bool valid_ = false;
+};
+
+struct recipient {
+    text_view to;
+    amount value;
+    bytes_view payload;
+};
+
+/// One page of one display item, key and value live in the iterator
+struct display_page {
+    uint8_t index;
+    uint8_t page;
+    uint8_t pageCount;
+    text_view key;
+    text_view value;
+    parser_error_t error;
+};
+
+/// Parsed transaction, the blob must outlive it
+class transaction {
+public:
+    transaction() { MEMZERO(&tx_, sizeof(tx_)); }
+    transaction(const transaction &) = delete;
+    transaction &operator=(const transaction &) = delete;
+
+    parser_error_t parse(const uint8_t *data, size_t dataLen) {
+        MEMZERO(&tx_, sizeof(tx_));
+        ctx_.buffer = data;
+        ctx_.bufferLen = 0;
+        ctx_.offset = 0;
+        ctx_.tx_obj = &tx_;
+        parsed_ = false;
+        if (data == nullptr || dataLen == 0) {
+            return parser_init_context_empty;
+        }
+        if (dataLen > UINT16_MAX) {
+            return parser_value_out_of_range;
+        }
+        ctx_.bufferLen = static_cast<uint16_t>(dataLen);
+        CHECK_ERROR(_read(&ctx_, &tx_))
+        parsed_ = true;
+        return parser_ok;
+    }
+
+    parser_error_t validate() {
+        return parsed_ ? parser_validate(&ctx_) : parser_no_data;
+    }
+
+    const parser_tx_t &raw() const { return tx_; }
+    const parser_context_t &context() const { return ctx_; }
+
+    amount nonce() const { return amount(tx_.fields[MANTX_FIELD_NONCE]); }
+    amount gasPrice() const { return amount(tx_.fields[MANTX_FIELD_GASPRICE]); }
+    amount gasLimit() const { return amount(tx_.fields[MANTX_FIELD_GASLIMIT]); }
+    amount value() const { return amount(tx_.fields[MANTX_FIELD_VALUE]); }
+    text_view to() const { return text(tx_.fields[MANTX_FIELD_TO]); }
+    bytes_view data() const { return bytes(tx_.fields[MANTX_FIELD_DATA]); }
+    uint8_t txType() const { return tx_.extraTxType; }
+
+    /// Recipients of the extra To list
+    class recipient_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef recipient value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const recipient *pointer;
+        typedef const recipient &reference;
+
+        recipient_iterator(const parser_tx_t *tx, uint16_t idx) : tx_(tx), idx_(idx) { load(); }
+
+        const recipient &operator*() const { return current_; }
+        const recipient *operator->() const { return &current_; }
+        recipient_iterator &operator++() {
+            idx_++;
+            load();
+            return *this;
+        }
+        bool operator==(const recipient_iterator &other) const { return idx_ == other.idx_; }
+        bool operator!=(const recipient_iterator &other) const { return idx_ != other.idx_; }
+
+    private:
+        void load() {
+            current_ = recipient();
+            if (idx_ >= tx_->extraToFieldsItems) {
+                return;
+            }
+            rlp_t fields[MANTX_EXTRATOFIELD_COUNT];
+            uint16_t items = 0;
+            // Shape already checked by _read
+            if (rlp_readList(&tx_->extraToListFields[idx_], fields, &items, MANTX_EXTRATOFIELD_COUNT) != parser_ok ||
+                items != MANTX_EXTRATOFIELD_COUNT) {
+                return;
+            }
+            current_.to = text(fields[0]);
+            current_.value = amount(fields[1]);
+            current_.payload = bytes(fields[2]);
+        }
+
+        const parser_tx_t *tx_;
+        uint16_t idx_;
+        recipient current_;
+    };
+
+    struct recipient_range {
+        const parser_tx_t *tx;
+        recipient_iterator begin() const { return recipient_iterator(tx, 0); }
+        recipient_iterator end() const { return recipient_iterator(tx, tx->extraToFieldsItems); }
+        size_t size() const { return tx->extraToFieldsItems; }
+    };
+
+    recipient_range recipients() const { return recipient_range{&tx_}; }
+
+    /// Every page of every display item, as parser_getItem renders them. Empty until parsed.
+    template<uint16_t KeyLen = 40, uint16_t ValueLen = 40>
+    class page_iterator {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef display_page value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const display_page *pointer;
+        typedef const display_page &reference;
+
+        page_iterator(const parser_context_t *ctx, uint8_t index) : ctx_(ctx) {
+            page_.index = index;
+            page_.page = 0;
+            page_.pageCount = 1;
+            if (ctx_ == nullptr || parser_getNumItems(ctx_, &numItems_) != parser_ok) {
+                numItems_ = 0;
+            }
+            render();
+        }
+
+        // page_ views the iterator's own buffers, a copy must view its own
+        page_iterator(const page_iterator &other) : ctx_(other.ctx_), numItems_(other.numItems_), page_(other.page_) {
+            copyBuffers(other);
+        }
+        page_iterator &operator=(const page_iterator &other) {
+            if (this != &other) {
+                ctx_ = other.ctx_;
+                numItems_ = other.numItems_;
+                page_ = other.page_;
+                copyBuffers(other);
+            }
+            return *this;
+        }
+
+        const display_page &operator*() const { return page_; }
+        const display_page *operator->() const { return &page_; }
+        page_iterator &operator++() {
+            if (page_.error == parser_ok && page_.page + 1 < page_.pageCount) {
+                page_.page++;
+            } else {
+                page_.index++;
+                page_.page = 0;
+            }
+            render();
+            return *this;
+        }
+        bool operator==(const page_iterator &other) const {
+            return page_.index == other.page_.index && page_.page == other.page_.page;
+        }
+        bool operator!=(const page_iterator &other) const { return !(*this == other); }
+
+    private:
+        void render() {
+            if (page_.index >= numItems_) {
+                page_.index = numItems_;
+                page_.page = 0;
+                return;
+            }
+            page_.error = parser_getItem(ctx_, page_.index, key_, KeyLen, value_, ValueLen,
+                                         page_.page, &page_.pageCount);
+            page_.key = text_view(key_);
+            page_.value = text_view(value_);
+        }
+
+        void copyBuffers(const page_iterator &other) {
+            memcpy(key_, other.key_, KeyLen);
+            memcpy(value_, other.value_, ValueLen);
+            page_.key = text_view(key_, other.page_.key.size());
+            page_.value = text_view(value_, other.page_.value.size());
+        }
+
+        const parser_context_t *ctx_;
+        uint8_t numItems_ = 0;
+        char key_[KeyLen] = {0};
+        char value_[ValueLen] = {0};
+        display_page page_{};
+    };
+
+    template<uint16_t KeyLen = 40, uint16_t ValueLen = 40>
+    struct page_range {
+        const parser_context_t *ctx;
+        page_iterator<KeyLen, ValueLen> begin() const { return page_iterator<KeyLen, ValueLen>(ctx, 0); }
+        page_iterator<KeyLen, ValueLen> end() const { return page_iterator<KeyLen, ValueLen>(ctx, UINT8_MAX); }
+    };
+
+    template<uint16_t KeyLen = 40, uint16_t ValueLen = 40>
+    page_range<KeyLen, ValueLen> pages() const { return page_range<KeyLen, ValueLen>{parsed_ ? &ctx_ : nullptr}; }
+
+private:
+    static text_view text(const rlp_t &rlp) {
+        return text_view(reinterpret_cast<const char *>(rlp.ptr), static_cast<size_t>(rlp.rlpLen));
+    }
+    static bytes_view bytes(const rlp_t &rlp) {
+        return bytes_view(rlp.ptr, rlp.kind == RLP_KIND_BYTE ? 1 : static_cast<size_t>(rlp.rlpLen));
+    }
+
+    parser_tx_t tx_;
+    parser_context_t ctx_{};
+    bool parsed_ = false;
+};
+
+}
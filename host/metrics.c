@@ -0,0 +1,148 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "metrics.h"
+#include "host_build.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Every thread owns one block and is its only writer: plain load and store, no
+// locked instructions. Readers sum the blocks under the registry lock, exited
+// threads are folded into `retired`.
+typedef struct metrics_block_t {
+    parser_metrics_t counters;
+    struct metrics_block_t *prev;
+    struct metrics_block_t *next;
+} metrics_block_t;
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t registry_once = PTHREAD_ONCE_INIT;
+static pthread_key_t registry_key;
+static metrics_block_t *registry = NULL;
+static parser_metrics_t retired;
+
+static APP_THREAD_LOCAL metrics_block_t *thread_block = NULL;
+
+#define COUNTERS_LEN    (sizeof(parser_metrics_t) / sizeof(uint64_t))
+
+static void bump(uint64_t *counter, uint64_t amount) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + amount, __ATOMIC_RELAXED);
+}
+
+static void addCounters(parser_metrics_t *into, const parser_metrics_t *from) {
+    uint64_t *dst = (uint64_t *) into;
+    const uint64_t *src = (const uint64_t *) from;
+    for (size_t i = 0; i < COUNTERS_LEN; i++) {
+        dst[i] += __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+}
+
+static void retireBlock(void *ptr) {
+    metrics_block_t *block = (metrics_block_t *) ptr;
+    pthread_mutex_lock(&registry_lock);
+    addCounters(&retired, &block->counters);
+    if (block->prev != NULL) {
+        block->prev->next = block->next;
+    } else {
+        registry = block->next;
+    }
+    if (block->next != NULL) {
+        block->next->prev = block->prev;
+    }
+    pthread_mutex_unlock(&registry_lock);
+    free(block);
+}
+
+static void createKey(void) {
+    pthread_key_create(&registry_key, retireBlock);
+}
+
+static parser_metrics_t *threadCounters(void) {
+    if (thread_block != NULL) {
+        return &thread_block->counters;
+    }
+
+    metrics_block_t *block = calloc(1, sizeof(metrics_block_t));
+    if (block == NULL) {
+        return NULL;
+    }
+    pthread_once(&registry_once, createKey);
+    pthread_mutex_lock(&registry_lock);
+    block->next = registry;
+    if (registry != NULL) {
+        registry->prev = block;
+    }
+    registry = block;
+    pthread_mutex_unlock(&registry_lock);
+    pthread_setspecific(registry_key, block);
+
+    thread_block = block;
+    return &block->counters;
+}
+
+uint64_t metrics_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+void metrics_record(metrics_op_e op, uint64_t start, parser_error_t err) {
+    parser_metrics_t *m = threadCounters();
+    if (m == NULL || op >= METRICS_OPS) {
+        return;
+    }
+
+    const uint64_t elapsed = metrics_now() - start;
+    uint32_t bucket = elapsed == 0 ? 0 : 64u - (uint32_t) __builtin_clzll(elapsed);
+    if (bucket >= METRICS_LATENCY_BUCKETS) {
+        bucket = METRICS_LATENCY_BUCKETS - 1;
+    }
+    bump(&m->latency[op][bucket], 1);
+    bump(&m->results[op][(uint32_t) err < METRICS_ERROR_KINDS ? err : parser_unexpected_error], 1);
+}
+
+void metrics_recordTx(size_t bytes, uint8_t txType, uint16_t recipients) {
+    parser_metrics_t *m = threadCounters();
+    if (m == NULL) {
+        return;
+    }
+    bump(&m->txs, 1);
+    bump(&m->bytes, bytes);
+    bump(&m->recipients, recipients);
+    bump(&m->txTypes[txType], 1);
+}
+
+void metrics_snapshot(parser_metrics_t *out) {
+    if (out == NULL) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    pthread_mutex_lock(&registry_lock);
+    addCounters(out, &retired);
+    for (const metrics_block_t *block = registry; block != NULL; block = block->next) {
+        addCounters(out, &block->counters);
+    }
+    pthread_mutex_unlock(&registry_lock);
+}
+
+void metrics_merge(parser_metrics_t *into, const parser_metrics_t *from) {
+    if (into == NULL || from == NULL) {
+        return;
+    }
+    addCounters(into, from);
+}
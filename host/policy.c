@@ -0,0 +1,346 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "policy.h"
+#include "parser_impl.h"
+#include "rlp.h"
+
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    policy_field_e field;
+} field_name_t;
+
+static const field_name_t fieldNames[] = {
+    {"nonce", policy_field_nonce},
+    {"gasprice", policy_field_gasprice},
+    {"gaslimit", policy_field_gaslimit},
+    {"value", policy_field_value},
+    {"txtype", policy_field_txtype},
+    {"entrust", policy_field_entrust},
+    {"data", policy_field_data},
+    {"recipients", policy_field_recipients},
+    {"commit_age", policy_field_commit_age},
+    {"amount", policy_field_amount},
+    {"payload", policy_field_payload},
+};
+
+typedef struct {
+    const char *ptr;
+    const char *end;
+} cursor_t;
+
+// Limbs in order of significance, as rlp_readUInt256 fills them
+static uint64_t *limb(uint256_t *value, uint8_t idx) {
+    switch (idx) {
+        case 0: return &LOWER(LOWER_P(value));
+        case 1: return &UPPER(LOWER_P(value));
+        case 2: return &LOWER(UPPER_P(value));
+        default: return &UPPER(UPPER_P(value));
+    }
+}
+
+static void setSmall(uint256_t *value, uint64_t small) {
+    clear256(value);
+    LOWER(LOWER_P(value)) = small;
+}
+
+static void skipSpaces(cursor_t *c) {
+    while (c->ptr < c->end && (*c->ptr == ' ' || *c->ptr == '\t' || *c->ptr == '\r')) {
+        c->ptr++;
+    }
+}
+
+static bool accept(cursor_t *c, const char *token) {
+    const size_t len = strlen(token);
+    if ((size_t) (c->end - c->ptr) < len || memcmp(c->ptr, token, len) != 0) {
+        return false;
+    }
+    c->ptr += len;
+    return true;
+}
+
+static parser_error_t readField(cursor_t *c, uint8_t *field) {
+    const char *start = c->ptr;
+    while (c->ptr < c->end && ((*c->ptr >= 'a' && *c->ptr <= 'z') || *c->ptr == '_')) {
+        c->ptr++;
+    }
+    const size_t len = (size_t) (c->ptr - start);
+    for (size_t i = 0; i < sizeof(fieldNames) / sizeof(fieldNames[0]); i++) {
+        if (strlen(fieldNames[i].name) == len && memcmp(fieldNames[i].name, start, len) == 0) {
+            *field = (uint8_t) fieldNames[i].field;
+            return parser_ok;
+        }
+    }
+    return len == 0 ? parser_unexpected_characters : parser_unexpected_field;
+}
+
+static parser_error_t readOp(cursor_t *c, uint8_t *op) {
+    // Two character operators first
+    if (accept(c, "<=")) *op = policy_op_lte;
+    else if (accept(c, ">=")) *op = policy_op_gte;
+    else if (accept(c, "==")) *op = policy_op_eq;
+    else if (accept(c, "!=")) *op = policy_op_ne;
+    else if (accept(c, "<")) *op = policy_op_lt;
+    else if (accept(c, ">")) *op = policy_op_gt;
+    else if (accept(c, "in")) *op = policy_op_in;
+    else return parser_unexpected_characters;
+    return parser_ok;
+}
+
+static parser_error_t readDecimal(cursor_t *c, uint256_t *value) {
+    uint256_t ten;
+    setSmall(&ten, 10);
+    clear256(value);
+
+    const char *start = c->ptr;
+    while (c->ptr < c->end && *c->ptr >= '0' && *c->ptr <= '9') {
+        // Below 2^252, value * 10 + 9 cannot overflow
+        if (bits256(value) > 252) {
+            return parser_value_out_of_range;
+        }
+        uint256_t shifted, digit;
+        mul256(value, &ten, &shifted);
+        setSmall(&digit, (uint64_t) (*c->ptr - '0'));
+        add256(&shifted, &digit, value);
+        c->ptr++;
+    }
+    return c->ptr > start ? parser_ok : parser_unexpected_characters;
+}
+
+static parser_error_t readSet(cursor_t *c, uint256_t *bitmap) {
+    clear256(bitmap);
+    do {
+        skipSpaces(c);
+        uint256_t member;
+        CHECK_ERROR(readDecimal(c, &member))
+        if (bits256(&member) > 8) {
+            return parser_value_out_of_range;
+        }
+        const uint8_t bit = (uint8_t) LOWER(LOWER_P((&member)));
+        *limb(bitmap, bit / 64) |= 1ull << (bit % 64);
+        skipSpaces(c);
+    } while (accept(c, ","));
+    return parser_ok;
+}
+
+static parser_error_t compileRule(cursor_t *c, policy_insn_t *insn) {
+    skipSpaces(c);
+    CHECK_ERROR(readField(c, &insn->field))
+    skipSpaces(c);
+    CHECK_ERROR(readOp(c, &insn->op))
+    skipSpaces(c);
+
+    if (insn->op == policy_op_in) {
+        if (insn->field != policy_field_txtype) {
+            return parser_unexpected_field;
+        }
+        CHECK_ERROR(readSet(c, &insn->operand))
+    } else {
+        CHECK_ERROR(readDecimal(c, &insn->operand))
+    }
+
+    skipSpaces(c);
+    return c->ptr == c->end ? parser_ok : parser_unexpected_characters;
+}
+
+// 0: already decoded or a single byte, 1: one uint256, 2: one list per recipient
+static uint8_t costOf(uint8_t field) {
+    switch (field) {
+        case policy_field_txtype:
+        case policy_field_entrust:
+        case policy_field_data:
+        case policy_field_recipients:
+            return 0;
+        case policy_field_amount:
+        case policy_field_payload:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+parser_error_t policy_compile(const char *rules, size_t rulesLen, policy_program_t *program, uint8_t *errorRule) {
+    if ((rules == NULL && rulesLen > 0) || program == NULL) {
+        return parser_unexpected_error;
+    }
+    program->count = 0;
+
+    uint8_t rule = 0;
+    const char *end = rules + rulesLen;
+    for (const char *ptr = rules; ptr < end;) {
+        const char *ruleEnd = ptr;
+        while (ruleEnd < end && *ruleEnd != '\n' && *ruleEnd != ';') {
+            ruleEnd++;
+        }
+        cursor_t c = {ptr, ruleEnd};
+        const char *comment = memchr(ptr, '#', (size_t) (ruleEnd - ptr));
+        if (comment != NULL) {
+            c.end = comment;
+        }
+        ptr = ruleEnd + (ruleEnd < end ? 1 : 0);
+
+        skipSpaces(&c);
+        if (c.ptr == c.end) {
+            continue;
+        }
+        if (errorRule != NULL) {
+            *errorRule = rule;
+        }
+        if (program->count >= POLICY_MAX_RULES) {
+            return parser_unexpected_number_items;
+        }
+
+        policy_insn_t *insn = &program->insns[program->count];
+        insn->rule = rule++;
+        CHECK_ERROR(compileRule(&c, insn))
+
+        // Stable insertion by cost, rules keep their order within a class
+        for (uint8_t i = program->count; i > 0 && costOf(program->insns[i - 1].field) > costOf(program->insns[i].field); i--) {
+            const policy_insn_t tmp = program->insns[i - 1];
+            program->insns[i - 1] = program->insns[i];
+            program->insns[i] = tmp;
+        }
+        program->count++;
+    }
+    return parser_ok;
+}
+
+static bool holds(uint8_t op, uint256_t *value, const uint256_t *operandPtr) {
+    uint256_t operand = *operandPtr;
+    switch (op) {
+        case policy_op_lt:
+            return !gte256(value, &operand);
+        case policy_op_lte:
+            return !gt256(value, &operand);
+        case policy_op_gt:
+            return gt256(value, &operand);
+        case policy_op_gte:
+            return gte256(value, &operand);
+        case policy_op_eq:
+            return equal256(value, &operand);
+        case policy_op_ne:
+            return !equal256(value, &operand);
+        case policy_op_in:
+            return bits256(value) <= 8 &&
+                   (*limb(&operand, (uint8_t) (LOWER(LOWER_P(value)) / 64)) >> (LOWER(LOWER_P(value)) % 64)) & 1u;
+        default:
+            return false;
+    }
+}
+
+static uint64_t lengthOf(const rlp_t *rlp) {
+    return rlp->kind == RLP_KIND_BYTE ? 1 : rlp->rlpLen;
+}
+
+static parser_error_t loadScalar(const parser_tx_t *tx, uint8_t field, uint64_t now, uint256_t *value) {
+    switch (field) {
+        case policy_field_nonce:
+            return rlp_readUInt256(&tx->fields[MANTX_FIELD_NONCE], value);
+        case policy_field_gasprice:
+            return rlp_readUInt256(&tx->fields[MANTX_FIELD_GASPRICE], value);
+        case policy_field_gaslimit:
+            return rlp_readUInt256(&tx->fields[MANTX_FIELD_GASLIMIT], value);
+        case policy_field_value:
+            return rlp_readUInt256(&tx->fields[MANTX_FIELD_VALUE], value);
+        case policy_field_txtype:
+            setSmall(value, tx->extraTxType);
+            return parser_ok;
+        case policy_field_entrust:
+            return rlp_readUInt256(&tx->fields[MANTX_ROOT_ISENTRUSTTX], value);
+        case policy_field_data:
+            setSmall(value, lengthOf(&tx->fields[MANTX_FIELD_DATA]));
+            return parser_ok;
+        case policy_field_recipients:
+            setSmall(value, tx->extraToFieldsItems);
+            return parser_ok;
+        case policy_field_commit_age: {
+            uint256_t commitTime, current;
+            CHECK_ERROR(rlp_readUInt256(&tx->fields[MANTX_ROOT_COMMITTIME], &commitTime))
+            setSmall(&current, now);
+            if (gte256(&commitTime, &current)) {
+                minus256(&commitTime, &current, value);
+            } else {
+                minus256(&current, &commitTime, value);
+            }
+            return parser_ok;
+        }
+        default:
+            return parser_unexpected_field;
+    }
+}
+
+// Recipient fields must hold for every recipient
+static parser_error_t evalRecipients(const parser_tx_t *tx, const policy_insn_t *insn, bool *pass) {
+    *pass = true;
+    for (uint16_t i = 0; i < tx->extraToFieldsItems && *pass; i++) {
+        rlp_t items[MANTX_EXTRATOFIELD_COUNT];
+        uint16_t itemCount = 0;
+        CHECK_ERROR(rlp_readList(&tx->extraToListFields[i], items, &itemCount, MANTX_EXTRATOFIELD_COUNT))
+        if (itemCount != MANTX_EXTRATOFIELD_COUNT) {
+            return parser_unexpected_number_items;
+        }
+
+        uint256_t value;
+        if (insn->field == policy_field_amount) {
+            CHECK_ERROR(rlp_readUInt256(&items[1], &value))
+        } else {
+            setSmall(&value, lengthOf(&items[2]));
+        }
+        *pass = holds(insn->op, &value, &insn->operand);
+    }
+    return parser_ok;
+}
+
+parser_error_t policy_eval(const policy_program_t *program, const parser_tx_t *tx, uint64_t now,
+                           policy_result_t *result) {
+    if (program == NULL || tx == NULL || result == NULL) {
+        return parser_unexpected_error;
+    }
+    result->allowed = true;
+    result->rule = 0;
+
+    for (uint8_t i = 0; i < program->count; i++) {
+        const policy_insn_t *insn = &program->insns[i];
+        bool pass = false;
+        if (insn->field == policy_field_amount || insn->field == policy_field_payload) {
+            CHECK_ERROR(evalRecipients(tx, insn, &pass))
+        } else {
+            uint256_t value;
+            CHECK_ERROR(loadScalar(tx, insn->field, now, &value))
+            pass = holds(insn->op, &value, &insn->operand);
+        }
+
+        if (!pass) {
+            result->allowed = false;
+            result->rule = insn->rule;
+            return parser_ok;
+        }
+    }
+    return parser_ok;
+}
+
+parser_error_t policy_check(const policy_program_t *program, const uint8_t *data, uint16_t dataLen,
+                            uint64_t now, parser_tx_t *tx, policy_result_t *result) {
+    if (program == NULL || data == NULL || tx == NULL || result == NULL) {
+        return parser_unexpected_error;
+    }
+    result->allowed = false;
+
+    parser_context_t ctx = {.buffer = data, .bufferLen = dataLen, .offset = 0, .tx_obj = tx, .budget = NULL};
+    CHECK_ERROR(_read(&ctx, tx))
+    return policy_eval(program, tx, now, result);
+}
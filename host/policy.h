@@ -0,0 +1,101 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "parser_common.h"
+#include "parser_txdef.h"
+#include "uint256.h"
+
+// Host only: signing policies. A rule set is compiled once into a flat list of
+// comparisons that every transaction must pass, checked straight on the spans
+// _read located. Rules are separated by newlines or ';', '#' starts a comment:
+//
+//     value <= 1000000000000000000000
+//     amount <= 500000000000000000000      # every To [i] amount
+//     txtype in 0, 5, 6
+//     entrust == 0
+//     data <= 256                          # length in bytes
+//     commit_age <= 300                    # |now - CommitTime|
+//
+// Fields: nonce, gasprice, gaslimit, value, amount, txtype, entrust, data,
+// payload, recipients, commit_age. Operators: < <= > >= == != and `in` (txtype).
+
+#define POLICY_MAX_RULES    32u
+
+typedef enum {
+    policy_field_nonce = 0,
+    policy_field_gasprice,
+    policy_field_gaslimit,
+    policy_field_value,
+    policy_field_txtype,
+    policy_field_entrust,
+    policy_field_data,          // Data length
+    policy_field_recipients,    // number of To [i] entries
+    policy_field_commit_age,
+    policy_field_amount,        // every To [i] amount
+    policy_field_payload,       // every To [i] payload length
+} policy_field_e;
+
+typedef enum {
+    policy_op_lt = 0,
+    policy_op_lte,
+    policy_op_gt,
+    policy_op_gte,
+    policy_op_eq,
+    policy_op_ne,
+    policy_op_in,               // operand is a bitmap of the allowed values, 0..255
+} policy_op_e;
+
+typedef struct {
+    uint8_t field;              // policy_field_e
+    uint8_t op;                 // policy_op_e
+    uint8_t rule;               // position in the rule set
+    uint256_t operand;
+} policy_insn_t;
+
+/// Cheap checks first, each one can reject the transaction on its own
+typedef struct {
+    policy_insn_t insns[POLICY_MAX_RULES];
+    uint8_t count;
+} policy_program_t;
+
+typedef struct {
+    bool allowed;
+    uint8_t rule;               // first failing rule, when not allowed
+} policy_result_t;
+
+/// \param errorRule optional, the rule that could not be compiled
+parser_error_t policy_compile(const char *rules, size_t rulesLen, policy_program_t *program, uint8_t *errorRule);
+
+/// Evaluates a transaction read by _read. now is in the units of CommitTime.
+/// \return parser_ok once evaluated, result tells whether the policy allows it
+parser_error_t policy_eval(const policy_program_t *program, const parser_tx_t *tx, uint64_t now,
+                           policy_result_t *result);
+
+/// Reads the transaction and evaluates the policy in the same call
+parser_error_t policy_check(const policy_program_t *program, const uint8_t *data, uint16_t dataLen,
+                            uint64_t now, parser_tx_t *tx, policy_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
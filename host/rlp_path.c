@@ -0,0 +1,144 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "rlp_path.h"
+#include "rlp.h"
+
+#include <string.h>
+#include <zxmacros.h>
+
+#define RLP_PATH_ROOT   "root"
+
+parser_error_t rlp_path_compile(const char *expr, rlp_path_t *path) {
+    if (expr == NULL || path == NULL) {
+        return parser_unexpected_error;
+    }
+    MEMZERO(path, sizeof(*path));
+
+    const size_t rootLen = strlen(RLP_PATH_ROOT);
+    if (strncmp(expr, RLP_PATH_ROOT, rootLen) != 0) {
+        return parser_unexpected_characters;
+    }
+    const char *p = expr + rootLen;
+
+    while (*p != '\0') {
+        if (*p != '/') {
+            return parser_unexpected_characters;
+        }
+        p++;
+        if (path->stepCount == RLP_PATH_MAX_STEPS) {
+            return parser_value_out_of_range;
+        }
+
+        if (*p == '*') {
+            path->steps[path->stepCount++] = RLP_PATH_ANY;
+            p++;
+            continue;
+        }
+
+        if (*p < '0' || *p > '9') {
+            return parser_unexpected_characters;
+        }
+        uint32_t index = 0;
+        while (*p >= '0' && *p <= '9') {
+            index = index * 10 + (uint32_t) (*p - '0');
+            if (index >= RLP_PATH_ANY) {
+                return parser_value_out_of_range;
+            }
+            p++;
+        }
+        path->steps[path->stepCount++] = (uint16_t) index;
+    }
+
+    return parser_ok;
+}
+
+static parser_error_t matchStep(const rlp_path_t *path, rlp_path_match_t *match,
+                                rlp_path_cb_t callback, void *user) {
+    const uint8_t step = match->stepCount;
+    if (step == path->stepCount) {
+        return callback(match, user);
+    }
+    if (match->item.kind != RLP_KIND_LIST) {
+        return parser_ok;
+    }
+
+    const rlp_t list = match->item;
+    const uint16_t wanted = path->steps[step];
+    parser_context_t ctx = {.buffer = list.ptr, .bufferLen = (uint16_t) list.rlpLen, .offset = 0, .tx_obj = NULL};
+
+    for (uint16_t index = 0; ctx.offset < ctx.bufferLen; index++) {
+        // Reading an item only decodes its header, skipped payloads are never touched
+        CHECK_ERROR(rlp_read(&ctx, &match->item))
+        if (wanted != RLP_PATH_ANY && index != wanted) {
+            continue;
+        }
+
+        match->indices[step] = index;
+        match->stepCount = step + 1;
+        CHECK_ERROR(matchStep(path, match, callback, user))
+        if (match->stop) {
+            return parser_ok;
+        }
+        match->stepCount = step;
+
+        if (wanted != RLP_PATH_ANY) {
+            break;
+        }
+    }
+
+    match->item = list;
+    return parser_ok;
+}
+
+parser_error_t rlp_path_query(const rlp_path_t *path, const uint8_t *buffer, uint16_t bufferLen,
+                              rlp_path_cb_t callback, void *user) {
+    if (path == NULL || buffer == NULL || callback == NULL) {
+        return parser_unexpected_error;
+    }
+
+    rlp_path_match_t match;
+    MEMZERO(&match, sizeof(match));
+    parser_context_t ctx = {.buffer = buffer, .bufferLen = bufferLen, .offset = 0, .tx_obj = NULL};
+    CHECK_ERROR(rlp_read(&ctx, &match.item))
+    if (ctx.offset < ctx.bufferLen) {
+        return parser_unexpected_unparsed_bytes;
+    }
+
+    return matchStep(path, &match, callback, user);
+}
+
+typedef struct {
+    rlp_t *item;
+    bool found;
+} first_match_t;
+
+static parser_error_t takeFirst(rlp_path_match_t *match, void *user) {
+    first_match_t *first = (first_match_t *) user;
+    *first->item = match->item;
+    first->found = true;
+    match->stop = true;
+    return parser_ok;
+}
+
+parser_error_t rlp_path_first(const rlp_path_t *path, const uint8_t *buffer, uint16_t bufferLen, rlp_t *item) {
+    if (item == NULL) {
+        return parser_unexpected_error;
+    }
+
+    first_match_t first = {.item = item, .found = false};
+    CHECK_ERROR(rlp_path_query(path, buffer, bufferLen, takeFirst, &first))
+    return first.found ? parser_ok : parser_missing_field;
+}
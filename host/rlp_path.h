@@ -0,0 +1,63 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include "parser_common.h"
+#include "rlp_def.h"
+
+// Host only: path queries over RLP, e.g. "root/12/0/2/*/1" for every recipient amount.
+// "root" is the top level item, each step indexes into the current list and "*" visits
+// every item of it. Siblings that are not selected are skipped by their header, their
+// payload is never read.
+
+#define RLP_PATH_MAX_STEPS  16u
+#define RLP_PATH_ANY        UINT16_MAX
+
+typedef struct {
+    uint16_t steps[RLP_PATH_MAX_STEPS];     // list index or RLP_PATH_ANY
+    uint8_t stepCount;
+} rlp_path_t;
+
+typedef struct {
+    rlp_t item;
+    uint16_t indices[RLP_PATH_MAX_STEPS];   // the index taken at every step
+    uint8_t stepCount;
+    bool stop;                              // set by the callback to end the query
+} rlp_path_match_t;
+
+/// Any error returned by the callback stops the query and is returned by it.
+/// Setting match->stop ends the query after this match, the query returns parser_ok.
+typedef parser_error_t (*rlp_path_cb_t)(rlp_path_match_t *match, void *user);
+
+/// Compiles expr once so it can be run over many buffers
+parser_error_t rlp_path_compile(const char *expr, rlp_path_t *path);
+
+/// Runs path over the single root item of buffer. Items whose shape does not fit the
+/// path (a step into a non list, an index past the end) are not matches, not errors.
+parser_error_t rlp_path_query(const rlp_path_t *path, const uint8_t *buffer, uint16_t bufferLen,
+                              rlp_path_cb_t callback, void *user);
+
+/// First match only, parser_missing_field when there is none
+parser_error_t rlp_path_first(const rlp_path_t *path, const uint8_t *buffer, uint16_t bufferLen, rlp_t *item);
+
+#ifdef __cplusplus
+}
+#endif
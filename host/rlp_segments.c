@@ -0,0 +1,186 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "rlp_segments.h"
+#include "parser_impl.h"
+#include "rlp.h"
+
+#include <string.h>
+
+// Moves past exhausted (or empty) segments
+static void skipEmpty(rlp_sg_t *sg) {
+    while (sg->segment < sg->segmentCount && sg->offset >= sg->segments[sg->segment].len) {
+        sg->segment++;
+        sg->offset = 0;
+    }
+}
+
+static const uint8_t *position(rlp_sg_t *sg) {
+    skipEmpty(sg);
+    return sg->segment < sg->segmentCount ? sg->segments[sg->segment].ptr + sg->offset : NULL;
+}
+
+// Consumes len bytes. *ptr points into the fragment when they are contiguous, otherwise
+// into scratch when gathering, or NULL
+static parser_error_t take(rlp_sg_t *sg, uint64_t len, bool gather, const uint8_t **ptr) {
+    if (len > sg->remaining) {
+        return parser_unexpected_buffer_end;
+    }
+    *ptr = position(sg);
+    if (len == 0) {
+        return parser_ok;
+    }
+
+    if (len <= sg->segments[sg->segment].len - sg->offset) {
+        sg->offset += len;
+        sg->remaining -= len;
+        return parser_ok;
+    }
+
+    uint8_t *dst = NULL;
+    if (gather) {
+        if (sg->scratch == NULL || len > sg->scratch->len - sg->scratch->used) {
+            return parser_scratch_exhausted;
+        }
+        dst = sg->scratch->buffer + sg->scratch->used;
+        sg->scratch->used += len;
+        *ptr = dst;
+    } else {
+        *ptr = NULL;
+    }
+
+    sg->remaining -= len;
+    while (len > 0) {
+        skipEmpty(sg);
+        if (sg->segment >= sg->segmentCount) {
+            return parser_unexpected_buffer_end;
+        }
+        const uint32_t left = sg->segments[sg->segment].len - sg->offset;
+        const uint32_t n = len < left ? (uint32_t) len : left;
+        if (dst != NULL) {
+            memcpy(dst, sg->segments[sg->segment].ptr + sg->offset, n);
+            dst += n;
+        }
+        sg->offset += n;
+        len -= n;
+    }
+
+    return parser_ok;
+}
+
+static parser_error_t readByte(rlp_sg_t *sg, uint8_t *value, const uint8_t **ptr) {
+    CHECK_ERROR(take(sg, 1, false, ptr))
+    *value = **ptr;
+    return parser_ok;
+}
+
+static parser_error_t readItem(rlp_sg_t *sg, rlp_t *rlp, rlp_sg_t *list, bool gatherList) {
+    if (sg == NULL || rlp == NULL) {
+        return parser_unexpected_error;
+    }
+
+    uint8_t prefix = 0;
+    const uint8_t *prefixPtr = NULL;
+    CHECK_ERROR(readByte(sg, &prefix, &prefixPtr))
+
+    uint8_t lenBytes = 0;
+    rlp_decodePrefix(prefix, &rlp->kind, &rlp->rlpLen, &lenBytes);
+    if (rlp->kind == RLP_KIND_BYTE) {
+        rlp->ptr = prefixPtr;
+        return parser_ok;
+    }
+
+    // Length bytes may straddle, they are read one at a time
+    for (uint8_t i = 0; i < lenBytes; i++) {
+        uint8_t value = 0;
+        const uint8_t *ptr = NULL;
+        CHECK_ERROR(readByte(sg, &value, &ptr))
+        rlp->rlpLen = (rlp->rlpLen << 8u) | value;
+    }
+    if (rlp->rlpLen > sg->remaining) {
+        return parser_unexpected_buffer_end;
+    }
+
+    if (rlp->kind == RLP_KIND_LIST && list != NULL) {
+        *list = *sg;
+        list->remaining = rlp->rlpLen;
+    }
+    return take(sg, rlp->rlpLen, rlp->kind != RLP_KIND_LIST || gatherList, &rlp->ptr);
+}
+
+parser_error_t rlp_sg_init(rlp_sg_t *sg, const rlp_segment_t *segments, uint16_t segmentCount,
+                           rlp_sg_scratch_t *scratch) {
+    if (sg == NULL || (segments == NULL && segmentCount > 0)) {
+        return parser_unexpected_error;
+    }
+
+    MEMZERO(sg, sizeof(*sg));
+    sg->segments = segments;
+    sg->segmentCount = segmentCount;
+    sg->scratch = scratch;
+    for (uint16_t i = 0; i < segmentCount; i++) {
+        if (segments[i].ptr == NULL && segments[i].len > 0) {
+            return parser_unexpected_error;
+        }
+        sg->remaining += segments[i].len;
+    }
+    return parser_ok;
+}
+
+parser_error_t rlp_sg_read(rlp_sg_t *sg, rlp_t *rlp, rlp_sg_t *list) {
+    return readItem(sg, rlp, list, false);
+}
+
+parser_error_t rlp_sg_readFlat(rlp_sg_t *sg, rlp_t *rlp) {
+    return readItem(sg, rlp, NULL, true);
+}
+
+bool rlp_sg_done(const rlp_sg_t *sg) {
+    return sg == NULL || sg->remaining == 0;
+}
+
+parser_error_t rlp_sg_readTx(const rlp_segment_t *segments, uint16_t segmentCount,
+                             rlp_sg_scratch_t *scratch, parser_tx_t *tx) {
+    if (tx == NULL) {
+        return parser_unexpected_error;
+    }
+    MEMZERO(tx, sizeof(*tx));
+
+    rlp_sg_t sg;
+    rlp_sg_t root;
+    CHECK_ERROR(rlp_sg_init(&sg, segments, segmentCount, scratch))
+
+    // We expect a single root list, its fields are read in place
+    CHECK_ERROR(rlp_sg_read(&sg, &tx->root, &root))
+    if (!rlp_sg_done(&sg)) {
+        return parser_unexpected_unparsed_bytes;
+    }
+    if (tx->root.kind != RLP_KIND_LIST) {
+        return parser_unexpected_type;
+    }
+
+    while (!rlp_sg_done(&root)) {
+        if (tx->rootFieldsItems == MANTX_ROOTFIELD_COUNT) {
+            return parser_unexpected_number_items;
+        }
+        CHECK_ERROR(rlp_sg_readFlat(&root, &tx->fields[tx->rootFieldsItems]))
+        tx->rootFieldsItems++;
+    }
+    if (tx->rootFieldsItems != MANTX_ROOTFIELD_COUNT) {
+        return parser_unexpected_number_items;
+    }
+
+    return _readFields(tx);
+}
@@ -0,0 +1,71 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include "parser_common.h"
+#include "parser_txdef.h"
+#include "rlp_def.h"
+
+// Host only: RLP over scatter-gather input (a chain of fragments).
+// Items are returned in place, only items that straddle two fragments are
+// gathered into the caller's scratch buffer.
+
+typedef struct {
+    const uint8_t *ptr;
+    uint32_t len;
+} rlp_segment_t;
+
+typedef struct {
+    uint8_t *buffer;
+    uint32_t len;
+    uint32_t used;
+} rlp_sg_scratch_t;
+
+/// Read cursor over one nesting level
+typedef struct {
+    const rlp_segment_t *segments;
+    uint16_t segmentCount;
+    uint16_t segment;
+    uint32_t offset;            // within the current segment
+    uint64_t remaining;         // bytes left at this level
+    rlp_sg_scratch_t *scratch;  // shared with nested cursors
+} rlp_sg_t;
+
+parser_error_t rlp_sg_init(rlp_sg_t *sg, const rlp_segment_t *segments, uint16_t segmentCount,
+                           rlp_sg_scratch_t *scratch);
+
+/// Reads the next item. Lists are not gathered: ptr is NULL when the payload straddles
+/// fragments, `list` (optional) receives a cursor over its items instead.
+parser_error_t rlp_sg_read(rlp_sg_t *sg, rlp_t *rlp, rlp_sg_t *list);
+
+/// Reads the next item, gathering straddling lists too so the result can go to rlp_readList
+parser_error_t rlp_sg_readFlat(rlp_sg_t *sg, rlp_t *rlp);
+
+/// \return true once every byte of this level has been read
+bool rlp_sg_done(const rlp_sg_t *sg);
+
+/// Same as _read but over fragments
+parser_error_t rlp_sg_readTx(const rlp_segment_t *segments, uint16_t segmentCount,
+                             rlp_sg_scratch_t *scratch, parser_tx_t *tx);
+
+#ifdef __cplusplus
+}
+#endif
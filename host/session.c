@@ -0,0 +1,142 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "session.h"
+#include "hex.h"
+#include "parser.h"
+
+#define SESSION_NONE    0u
+
+// Free list top: a 32 bit tag above index + 1. The tag changes on every push and
+// pop, so a stale compare-and-swap fails even if the same session came back (ABA).
+#define HEAD_INDEX(h)       ((uint32_t) (h))
+#define HEAD_TAG(h)         ((uint32_t) ((h) >> 32u))
+#define HEAD_MAKE(tag, idx) (((uint64_t) (tag) << 32u) | (idx))
+
+zxerr_t session_pool_init(session_pool_t *pool, parser_session_t *sessions, uint32_t count) {
+    if (pool == NULL || sessions == NULL || count == 0 || count == UINT32_MAX) {
+        return zxerr_unknown;
+    }
+
+    pool->sessions = sessions;
+    pool->count = count;
+    for (uint32_t i = 0; i < count; i++) {
+        sessions[i].generation = 0;
+        sessions[i].parsed = false;
+        sessions[i].ctx.budget = NULL;
+        sessions[i].next = i + 1 < count ? i + 2 : SESSION_NONE;
+    }
+    __atomic_store_n(&pool->head, HEAD_MAKE(0, 1), __ATOMIC_RELEASE);
+    return zxerr_ok;
+}
+
+parser_session_t *session_acquire(session_pool_t *pool) {
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    uint64_t head = __atomic_load_n(&pool->head, __ATOMIC_ACQUIRE);
+    while (HEAD_INDEX(head) != SESSION_NONE) {
+        parser_session_t *top = &pool->sessions[HEAD_INDEX(head) - 1];
+        const uint32_t next = __atomic_load_n(&top->next, __ATOMIC_RELAXED);
+        const uint64_t newHead = HEAD_MAKE(HEAD_TAG(head) + 1, next);
+        if (__atomic_compare_exchange_n(&pool->head, &head, newHead, true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+            return top;
+        }
+    }
+    return NULL;
+}
+
+void session_release(session_pool_t *pool, parser_session_t *session) {
+    if (pool == NULL || session == NULL || session < pool->sessions || session >= pool->sessions + pool->count) {
+        return;
+    }
+
+    // Outstanding handles must not see the next user's transaction
+    session->generation++;
+    session->parsed = false;
+
+    const uint32_t idx = (uint32_t) (session - pool->sessions) + 1;
+    uint64_t head = __atomic_load_n(&pool->head, __ATOMIC_RELAXED);
+    do {
+        __atomic_store_n(&session->next, HEAD_INDEX(head), __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&pool->head, &head, HEAD_MAKE(HEAD_TAG(head) + 1, idx),
+                                          true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+parser_error_t session_parse(parser_session_t *session, const uint8_t *data, size_t dataLen) {
+    if (session == NULL) {
+        return parser_unexpected_error;
+    }
+    session->generation++;
+    session->parsed = false;
+    if (data == NULL || dataLen == 0) {
+        return parser_init_context_empty;
+    }
+    if (dataLen > UINT16_MAX) {
+        return parser_value_out_of_range;
+    }
+
+    parser_tx_t *tx = &session->tx;
+    session->ctx.buffer = data;
+    session->ctx.bufferLen = (uint16_t) dataLen;
+    session->ctx.offset = 0;
+    session->ctx.tx_obj = tx;
+    CHECK_ERROR(_read(&session->ctx, tx))
+    session->parsed = true;
+    return parser_ok;
+}
+
+parser_error_t session_parseHex(parser_session_t *session, const char *hex, size_t hexLen) {
+    if (session == NULL || hex == NULL) {
+        return parser_unexpected_error;
+    }
+    session->parsed = false;
+    if (hexLen / 2 > sizeof(session->blob)) {
+        return parser_scratch_exhausted;
+    }
+
+    size_t blobLen = 0;
+    if (!hex_decode(hex, hexLen, session->blob, sizeof(session->blob), &blobLen)) {
+        return parser_unexpected_characters;
+    }
+    return session_parse(session, session->blob, blobLen);
+}
+
+parser_error_t session_validate(parser_session_t *session) {
+    if (session == NULL || !session->parsed) {
+        return parser_no_data;
+    }
+    return parser_validate(&session->ctx);
+}
+
+session_handle_t session_handle(parser_session_t *session) {
+    session_handle_t handle = {.session = session, .generation = session != NULL ? session->generation : 0};
+    return handle;
+}
+
+bool session_isCurrent(session_handle_t handle) {
+    return handle.session != NULL && handle.session->parsed && handle.session->generation == handle.generation;
+}
+
+parser_error_t session_getItem(parser_session_t *session, uint8_t displayIdx, uint8_t pageIdx, uint8_t *pageCount) {
+    if (session == NULL || !session->parsed) {
+        return parser_no_data;
+    }
+    return parser_getItem(&session->ctx, displayIdx,
+                          session->key, sizeof(session->key),
+                          session->value, sizeof(session->value),
+                          pageIdx, pageCount);
+}
@@ -0,0 +1,84 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "parser_common.h"
+#include "parser_txdef.h"
+#include "zxerror.h"
+
+// Host only: reusable parse sessions for services. A session owns everything one
+// request needs (decoded blob, transaction, render buffers) and is recycled through
+// a lock-free pool, so steady state parsing neither allocates nor clears whole structs.
+
+#ifndef SESSION_BLOB_LEN
+#define SESSION_BLOB_LEN    16384u
+#endif
+#define SESSION_KEY_LEN     64u
+#define SESSION_VALUE_LEN   128u
+
+typedef struct {
+    parser_tx_t tx;
+    parser_context_t ctx;           // ctx.budget, when set, bounds parse, validate and getItem
+    uint32_t generation;            // bumped on every parse, stale handles stop matching
+    bool parsed;
+    uint32_t next;                  // free list link, pool internal
+    uint8_t blob[SESSION_BLOB_LEN];
+    char key[SESSION_KEY_LEN];
+    char value[SESSION_VALUE_LEN];
+} parser_session_t;
+
+/// Refers to one parse of a session
+typedef struct {
+    parser_session_t *session;
+    uint32_t generation;
+} session_handle_t;
+
+typedef struct {
+    parser_session_t *sessions;
+    uint32_t count;
+    uint64_t head;                  // free list top: ABA tag << 32 | (index + 1), 0 when empty
+} session_pool_t;
+
+/// sessions is caller owned storage (one arena) for count sessions
+zxerr_t session_pool_init(session_pool_t *pool, parser_session_t *sessions, uint32_t count);
+
+/// \return a free session or NULL when all of them are in use
+parser_session_t *session_acquire(session_pool_t *pool);
+void session_release(session_pool_t *pool, parser_session_t *session);
+
+/// Parses data in place, it must outlive the parse
+parser_error_t session_parse(parser_session_t *session, const uint8_t *data, size_t dataLen);
+/// Decodes hex into the session blob and parses it
+parser_error_t session_parseHex(parser_session_t *session, const char *hex, size_t hexLen);
+parser_error_t session_validate(parser_session_t *session);
+
+session_handle_t session_handle(parser_session_t *session);
+/// \return false once the session was parsed again or never parsed successfully
+bool session_isCurrent(session_handle_t handle);
+
+/// Renders into session->key and session->value
+parser_error_t session_getItem(parser_session_t *session, uint8_t displayIdx, uint8_t pageIdx, uint8_t *pageCount);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,322 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "sigcheck.h"
+#include "crypto_helper.h"
+#include "keccak.h"
+#include "parser_impl.h"
+#include "rlp.h"
+
+#include <secp256k1.h>
+#include <secp256k1_recovery.h>
+#include <string.h>
+
+#define SIGCHECK_CHUNK  64
+
+// Points right after the encoded field
+static const uint8_t *fieldEnd(const rlp_t *rlp) {
+    return rlp->ptr + (rlp->kind == RLP_KIND_BYTE ? 1 : rlp->rlpLen);
+}
+
+static parser_error_t readUInt64(const rlp_t *rlp, uint64_t *value) {
+    if (rlp->kind == RLP_KIND_BYTE) {
+        *value = *rlp->ptr;
+        return parser_ok;
+    }
+    if (rlp->kind != RLP_KIND_STRING || rlp->rlpLen > sizeof(uint64_t)) {
+        return parser_unexpected_value;
+    }
+    *value = 0;
+    for (uint8_t i = 0; i < rlp->rlpLen; i++) {
+        *value = (*value << 8u) | rlp->ptr[i];
+    }
+    return parser_ok;
+}
+
+// Left pads a big endian integer to 32 bytes
+static parser_error_t readScalar(const rlp_t *rlp, uint8_t *out) {
+    MEMZERO(out, SIGCHECK_SCALAR_LEN);
+    if (rlp->kind == RLP_KIND_BYTE) {
+        out[SIGCHECK_SCALAR_LEN - 1] = *rlp->ptr;
+        return parser_ok;
+    }
+    if (rlp->kind != RLP_KIND_STRING || rlp->rlpLen == 0 || rlp->rlpLen > SIGCHECK_SCALAR_LEN) {
+        return parser_unexpected_value;
+    }
+    MEMCPY(out + SIGCHECK_SCALAR_LEN - rlp->rlpLen, rlp->ptr, rlp->rlpLen);
+    return parser_ok;
+}
+
+// Minimal big endian bytes of value
+static uint8_t encodeLength(uint8_t *out, uint64_t value) {
+    uint8_t len = 0;
+    for (uint64_t v = value; v != 0; v >>= 8u) {
+        len++;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+        out[i] = (uint8_t) (value >> (8u * (len - 1 - i)));
+    }
+    return len;
+}
+
+static parser_error_t hashSpan(keccak_ctx_t *hash, const uint8_t *data, size_t len) {
+    return keccak_update(hash, data, len) == zxerr_ok ? parser_ok : parser_unexpected_error;
+}
+
+// Called once S has been read: decides whether the transaction is signed and, if so,
+// starts the signing form with every field up to V and chainId, "", "" for V, R, S
+static parser_error_t startSigningHash(const parser_tx_t *tx, sigcheck_hashes_t *hashes, keccak_ctx_t *hash) {
+    const rlp_t *r = &tx->fields[MANTX_ROOT_R];
+    const rlp_t *s = &tx->fields[MANTX_ROOT_S];
+    uint64_t v = 0;
+    CHECK_ERROR(readUInt64(&tx->fields[MANTX_FIELD_V], &v))
+
+    hashes->isSigned = !(r->kind == RLP_KIND_STRING && r->rlpLen == 0 && s->kind == RLP_KIND_STRING && s->rlpLen == 0);
+    if (!hashes->isSigned) {
+        // Already in signing form, V holds the chain id
+        hashes->chainId = v;
+        return parser_ok;
+    }
+    if (v < SIGCHECK_EIP155_OFFSET) {
+        return parser_unexpected_value;
+    }
+    hashes->chainId = (v - SIGCHECK_EIP155_OFFSET) / 2;
+
+    uint8_t chainRlp[1 + sizeof(uint64_t)];
+    uint8_t chainRlpLen = 1;
+    if (hashes->chainId == 0) {
+        chainRlp[0] = RLP_KIND_STRING_SHORT_MIN;
+    } else if (hashes->chainId <= RLP_KIND_BYTE_PREFIX) {
+        chainRlp[0] = (uint8_t) hashes->chainId;
+    } else {
+        const uint8_t len = encodeLength(chainRlp + 1, hashes->chainId);
+        chainRlp[0] = RLP_KIND_STRING_SHORT_MIN + len;
+        chainRlpLen += len;
+    }
+    const uint8_t emptyRS[2] = {RLP_KIND_STRING_SHORT_MIN, RLP_KIND_STRING_SHORT_MIN};
+
+    const uint8_t *head = tx->root.ptr;
+    const uint8_t *headEnd = fieldEnd(&tx->fields[MANTX_FIELD_V - 1]);
+    const uint64_t vrsLen = (uint64_t) (fieldEnd(s) - headEnd);
+    const uint64_t payloadLen = tx->root.rlpLen - vrsLen + chainRlpLen + sizeof(emptyRS);
+
+    uint8_t header[1 + sizeof(uint64_t)];
+    uint8_t headerLen = 1;
+    if (payloadLen <= RLP_KIND_LIST_SHORT_MAX - RLP_KIND_LIST_SHORT_MIN) {
+        header[0] = (uint8_t) (RLP_KIND_LIST_SHORT_MIN + payloadLen);
+    } else {
+        const uint8_t len = encodeLength(header + 1, payloadLen);
+        header[0] = RLP_KIND_LIST_SHORT_MAX + len;
+        headerLen += len;
+    }
+
+    CHECK_ERROR(hashSpan(hash, header, headerLen))
+    CHECK_ERROR(hashSpan(hash, head, headEnd - head))
+    CHECK_ERROR(hashSpan(hash, chainRlp, chainRlpLen))
+    return hashSpan(hash, emptyRS, sizeof(emptyRS));
+}
+
+parser_error_t sigcheck_parseTx(const uint8_t *data, uint16_t dataLen, parser_tx_t *tx, sigcheck_hashes_t *hashes) {
+    if (data == NULL || tx == NULL || hashes == NULL) {
+        return parser_unexpected_error;
+    }
+    MEMZERO(tx, sizeof(*tx));
+    MEMZERO(hashes, sizeof(*hashes));
+
+    // We expect a single root list
+    parser_context_t ctx = {.buffer = data, .bufferLen = dataLen, .offset = 0, .tx_obj = NULL};
+    CHECK_ERROR(rlp_read(&ctx, &tx->root))
+    if (ctx.offset < ctx.bufferLen) {
+        return parser_unexpected_unparsed_bytes;
+    }
+    if (tx->root.kind != RLP_KIND_LIST) {
+        return parser_unexpected_type;
+    }
+
+    keccak_ctx_t txHash;
+    keccak_ctx_t signingHash;
+    if (keccak_init(&txHash) != zxerr_ok || keccak_init(&signingHash) != zxerr_ok) {
+        return parser_unexpected_error;
+    }
+    CHECK_ERROR(hashSpan(&txHash, data, tx->root.ptr - data))
+
+    // Root fields: each span feeds the transaction hash as it is read, fields after S
+    // also feed the signing form
+    parser_context_t fields = {.buffer = tx->root.ptr, .bufferLen = tx->root.rlpLen, .offset = 0, .tx_obj = NULL};
+    while (fields.offset < fields.bufferLen) {
+        if (tx->rootFieldsItems == MANTX_ROOTFIELD_COUNT) {
+            return parser_unexpected_number_items;
+        }
+        const uint16_t start = fields.offset;
+        CHECK_ERROR(rlp_read(&fields, &tx->fields[tx->rootFieldsItems]))
+        const uint8_t *span = fields.buffer + start;
+        const uint16_t spanLen = fields.offset - start;
+
+        CHECK_ERROR(hashSpan(&txHash, span, spanLen))
+        if (tx->rootFieldsItems == MANTX_ROOT_S) {
+            CHECK_ERROR(startSigningHash(tx, hashes, &signingHash))
+        } else if (tx->rootFieldsItems > MANTX_ROOT_S && hashes->isSigned) {
+            CHECK_ERROR(hashSpan(&signingHash, span, spanLen))
+        }
+        tx->rootFieldsItems++;
+    }
+    if (tx->rootFieldsItems != MANTX_ROOTFIELD_COUNT) {
+        return parser_unexpected_number_items;
+    }
+    CHECK_ERROR(_readFields(tx))
+
+    if (keccak_final(&txHash, hashes->txHash, sizeof(hashes->txHash)) != zxerr_ok) {
+        return parser_unexpected_error;
+    }
+    if (!hashes->isSigned) {
+        MEMCPY(hashes->signingHash, hashes->txHash, sizeof(hashes->signingHash));
+    } else if (keccak_final(&signingHash, hashes->signingHash, sizeof(hashes->signingHash)) != zxerr_ok) {
+        return parser_unexpected_error;
+    }
+
+    return parser_ok;
+}
+
+parser_error_t sigcheck_readSignedTx(const uint8_t *data, uint16_t dataLen, sigcheck_sig_t *sig, uint64_t *chainId) {
+    if (data == NULL || sig == NULL) {
+        return parser_unexpected_error;
+    }
+
+    parser_tx_t tx;
+    sigcheck_hashes_t hashes;
+    CHECK_ERROR(sigcheck_parseTx(data, dataLen, &tx, &hashes))
+    if (!hashes.isSigned) {
+        return parser_unexpected_value;
+    }
+
+    uint64_t v = 0;
+    CHECK_ERROR(readUInt64(&tx.fields[MANTX_FIELD_V], &v))
+    CHECK_ERROR(readScalar(&tx.fields[MANTX_ROOT_R], sig->r))
+    CHECK_ERROR(readScalar(&tx.fields[MANTX_ROOT_S], sig->s))
+    sig->recid = (uint8_t) ((v - SIGCHECK_EIP155_OFFSET) & 1u);
+    MEMCPY(sig->digest, hashes.signingHash, sizeof(sig->digest));
+    if (chainId != NULL) {
+        *chainId = hashes.chainId;
+    }
+
+    return parser_ok;
+}
+
+zxerr_t sigcheck_readSignature(const uint8_t *message, uint16_t messageLen, const uint8_t *rsv, sigcheck_sig_t *sig) {
+    if (message == NULL || rsv == NULL || sig == NULL) {
+        return zxerr_no_data;
+    }
+
+    const uint8_t v = rsv[2 * SIGCHECK_SCALAR_LEN];
+    if (v > 1 && v != 27 && v != 28) {
+        return zxerr_invalid_crypto_settings;
+    }
+    MEMCPY(sig->r, rsv, SIGCHECK_SCALAR_LEN);
+    MEMCPY(sig->s, rsv + SIGCHECK_SCALAR_LEN, SIGCHECK_SCALAR_LEN);
+    sig->recid = v & 1u;
+    if (v >= 27) {
+        sig->recid ^= 1u;
+    }
+
+    return keccak_hash(message, messageLen, sig->digest, sizeof(sig->digest));
+}
+
+// Serializes an uncompressed key without its 0x04 prefix
+static void writePubkey(const secp256k1_pubkey *key, uint8_t *pubkey) {
+    uint8_t serialized[1 + SIGCHECK_PUBKEY_LEN];
+    size_t serializedLen = sizeof(serialized);
+    secp256k1_ec_pubkey_serialize(secp256k1_context_static, serialized, &serializedLen, key,
+                                  SECP256K1_EC_UNCOMPRESSED);
+    MEMCPY(pubkey, serialized + 1, SIGCHECK_PUBKEY_LEN);
+}
+
+bool sigcheck_verify(const sigcheck_sig_t *sig, const uint8_t *pubkey) {
+    if (sig == NULL || pubkey == NULL) {
+        return false;
+    }
+
+    uint8_t rs[2 * SIGCHECK_SCALAR_LEN];
+    uint8_t serialized[1 + SIGCHECK_PUBKEY_LEN] = {0x04};
+    MEMCPY(rs, sig->r, SIGCHECK_SCALAR_LEN);
+    MEMCPY(rs + SIGCHECK_SCALAR_LEN, sig->s, SIGCHECK_SCALAR_LEN);
+    MEMCPY(serialized + 1, pubkey, SIGCHECK_PUBKEY_LEN);
+
+    secp256k1_ecdsa_signature signature;
+    secp256k1_pubkey key;
+    if (!secp256k1_ecdsa_signature_parse_compact(secp256k1_context_static, &signature, rs) ||
+        !secp256k1_ec_pubkey_parse(secp256k1_context_static, &key, serialized, sizeof(serialized))) {
+        return false;
+    }
+    // Only accepts lower-S signatures
+    return secp256k1_ecdsa_verify(secp256k1_context_static, &signature, sig->digest, &key) == 1;
+}
+
+bool sigcheck_recover(const sigcheck_sig_t *sig, uint8_t *pubkey) {
+    if (sig == NULL || pubkey == NULL || sig->recid > 3) {
+        return false;
+    }
+
+    uint8_t rs[2 * SIGCHECK_SCALAR_LEN];
+    MEMCPY(rs, sig->r, SIGCHECK_SCALAR_LEN);
+    MEMCPY(rs + SIGCHECK_SCALAR_LEN, sig->s, SIGCHECK_SCALAR_LEN);
+
+    secp256k1_ecdsa_recoverable_signature recoverable;
+    if (!secp256k1_ecdsa_recoverable_signature_parse_compact(secp256k1_context_static, &recoverable, rs, sig->recid)) {
+        return false;
+    }
+    // Recovery alone accepts both (r, s) and (r, n - s): normalize reports the upper half
+    secp256k1_ecdsa_signature signature;
+    secp256k1_ecdsa_recoverable_signature_convert(secp256k1_context_static, &signature, &recoverable);
+    if (secp256k1_ecdsa_signature_normalize(secp256k1_context_static, NULL, &signature)) {
+        return false;
+    }
+
+    secp256k1_pubkey key;
+    if (!secp256k1_ecdsa_recover(secp256k1_context_static, &key, &recoverable, sig->digest)) {
+        return false;
+    }
+    writePubkey(&key, pubkey);
+    return true;
+}
+
+zxerr_t sigcheck_recoverAddresses(const sigcheck_sig_t *sigs,
+                                  uint8_t (*addresses)[ADDRESS_LEN], uint8_t *addressLens,
+                                  bool *valid, uint16_t count) {
+    if (sigs == NULL || addresses == NULL || addressLens == NULL || valid == NULL) {
+        return zxerr_no_data;
+    }
+
+    // Keys are recovered one by one, addresses are hashed a chunk at a time
+    uint8_t pubkeys[SIGCHECK_CHUNK][SIGCHECK_PUBKEY_LEN];
+    for (uint16_t done = 0; done < count;) {
+        const uint16_t chunk = (count - done) < SIGCHECK_CHUNK ? (count - done) : SIGCHECK_CHUNK;
+        for (uint16_t i = 0; i < chunk; i++) {
+            valid[done + i] = sigcheck_recover(&sigs[done + i], pubkeys[i]);
+            if (!valid[done + i]) {
+                MEMZERO(pubkeys[i], SIGCHECK_PUBKEY_LEN);
+            }
+        }
+        CHECK_ZXERR(crypto_encodePubkeys(addresses + done, addressLens + done,
+                                         (const uint8_t (*)[SIGCHECK_PUBKEY_LEN]) pubkeys, chunk))
+        for (uint16_t i = done; i < done + chunk; i++) {
+            if (!valid[i]) {
+                addressLens[i] = 0;
+            }
+        }
+        done += chunk;
+    }
+
+    return zxerr_ok;
+}
@@ -0,0 +1,82 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "coin.h"
+#include "zxerror.h"
+#include "parser_common.h"
+#include "parser_txdef.h"
+
+// Host only: checks signed MAN transactions and device signatures.
+// The curve arithmetic is libsecp256k1's, through its static context: verification
+// and recovery need no signing tables, so nothing has to be set up or shared.
+
+// EIP-155: V = 35 + 2 * chainId + (R.y is odd)
+#define SIGCHECK_EIP155_OFFSET  35u
+#define SIGCHECK_SCALAR_LEN     32u
+#define SIGCHECK_PUBKEY_LEN     64u     // x || y, without the 0x04 prefix
+#define SIGCHECK_RSV_LEN        (2 * SIGCHECK_SCALAR_LEN + 1)
+
+typedef struct {
+    uint8_t digest[SIGCHECK_SCALAR_LEN];
+    uint8_t r[SIGCHECK_SCALAR_LEN];
+    uint8_t s[SIGCHECK_SCALAR_LEN];
+    uint8_t recid;                      // bit 0: R.y is odd, bit 1: R.x overflowed n
+} sigcheck_sig_t;
+
+typedef struct {
+    uint8_t txHash[KECCAK_HASH_SIZE];       // keccak of the whole RLP
+    uint8_t signingHash[KECCAK_HASH_SIZE];  // keccak of the form the device signs
+    uint64_t chainId;
+    bool isSigned;                          // false when R and S are empty
+} sigcheck_hashes_t;
+
+/// Parses like _read and, in the same scan over the root fields, hashes the
+/// transaction and its signing form (EIP-155: V = chainId, R and S empty).
+/// Unsigned transactions are already in signing form, both hashes match.
+parser_error_t sigcheck_parseTx(const uint8_t *data, uint16_t dataLen, parser_tx_t *tx, sigcheck_hashes_t *hashes);
+
+/// Reads V, R and S from a signed transaction and rebuilds the digest the device signed:
+/// keccak of the same transaction with V = chainId and empty R and S
+/// \param chainId optional
+parser_error_t sigcheck_readSignedTx(const uint8_t *data, uint16_t dataLen, sigcheck_sig_t *sig, uint64_t *chainId);
+
+/// Builds a signature from the message sent to the device and its R || S || V answer,
+/// V may be the parity (0, 1) or 27, 28
+zxerr_t sigcheck_readSignature(const uint8_t *message, uint16_t messageLen, const uint8_t *rsv, sigcheck_sig_t *sig);
+
+/// \return true if sig (digest, r, s) is valid for pubkey, recid is ignored.
+/// Malleated signatures (s > n / 2) are rejected.
+bool sigcheck_verify(const sigcheck_sig_t *sig, const uint8_t *pubkey);
+
+/// Recovers the signer's public key (x || y)
+/// \return false for malleated signatures (s > n / 2) and ones that do not recover to a key
+bool sigcheck_recover(const sigcheck_sig_t *sig, uint8_t *pubkey);
+
+/// Recovers the MAN address of each signer, addressLens is 0 where valid is false
+zxerr_t sigcheck_recoverAddresses(const sigcheck_sig_t *sigs,
+                                  uint8_t (*addresses)[ADDRESS_LEN], uint8_t *addressLens,
+                                  bool *valid, uint16_t count);
+
+#ifdef __cplusplus
+}
+#endif
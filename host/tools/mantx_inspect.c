@@ -0,0 +1,384 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+// Bulk inspection of MAN transactions
+//
+//   mantx-inspect [--hex] [--summary] [--threads N] FILE
+//
+// FILE holds transactions back to back, each behind a 2 byte big endian length
+// (the batch framing), or one hex encoded transaction per line with --hex.
+// Every transaction is parsed and validated, and one line per display item page
+// is written: "tx<TAB>item<TAB>key<TAB>value". Failures are written as
+// "tx<TAB>error<TAB>description". --summary only writes failures.
+// Totals go to stderr. Exits with 3 when any transaction is rejected.
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hex.h"
+#include "parser.h"
+#include "parser_txdef.h"
+
+#define INSPECT_CHUNK_TXS       1024u
+#define INSPECT_MAX_THREADS     256u
+#define INSPECT_ERROR_KINDS     64u
+#define INSPECT_KEY_LEN         64u
+#define INSPECT_VALUE_LEN       128u
+#define INSPECT_MAX_TX_LEN      UINT16_MAX
+
+typedef struct {
+    size_t offset;
+    size_t len;
+} span_t;
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} outbuf_t;
+
+typedef struct {
+    uint64_t txs;
+    uint64_t bytes;
+    uint64_t errors[INSPECT_ERROR_KINDS];
+} stats_t;
+
+typedef struct {
+    const uint8_t *input;
+    const span_t *spans;
+    size_t count;
+    size_t chunks;
+    bool hex;
+    bool summary;
+
+    atomic_size_t nextChunk;
+    outbuf_t *outputs;
+    bool *done;
+    pthread_mutex_t lock;
+    pthread_cond_t chunkDone;
+} job_t;
+
+typedef struct {
+    job_t *job;
+    stats_t stats;
+} worker_t;
+
+static bool outbuf_reserve(outbuf_t *out, size_t extra) {
+    if (out->len + extra <= out->cap) {
+        return true;
+    }
+    size_t cap = out->cap == 0 ? 4096 : out->cap;
+    while (cap < out->len + extra) {
+        cap *= 2;
+    }
+    char *data = realloc(out->data, cap);
+    if (data == NULL) {
+        return false;
+    }
+    out->data = data;
+    out->cap = cap;
+    return true;
+}
+
+__attribute__((format(printf, 2, 3)))
+static void outbuf_printf(outbuf_t *out, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    const int n = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+    if (n < 0 || !outbuf_reserve(out, (size_t) n + 1)) {
+        return;
+    }
+    va_start(args, fmt);
+    vsnprintf(out->data + out->len, (size_t) n + 1, fmt, args);
+    va_end(args);
+    out->len += (size_t) n;
+}
+
+// Splits the input into one span per transaction
+static bool readSpans(const uint8_t *input, size_t inputLen, bool hex, span_t **spans, size_t *count) {
+    size_t cap = 1024;
+    *count = 0;
+    *spans = malloc(cap * sizeof(span_t));
+    if (*spans == NULL) {
+        return false;
+    }
+
+    size_t offset = 0;
+    while (offset < inputLen) {
+        span_t span;
+        if (hex) {
+            const uint8_t *eol = memchr(input + offset, '\n', inputLen - offset);
+            size_t end = eol != NULL ? (size_t) (eol - input) : inputLen;
+            span.offset = offset;
+            span.len = end - offset;
+            if (span.len > 0 && input[end - 1] == '\r') {
+                span.len--;
+            }
+            offset = end + 1;
+            if (span.len == 0) {
+                continue;
+            }
+        } else {
+            if (inputLen - offset < MANTX_BATCH_LEN_PREFIX) {
+                fprintf(stderr, "truncated length prefix at offset %zu\n", offset);
+                return false;
+            }
+            span.len = (size_t) ((input[offset] << 8u) | input[offset + 1]);
+            span.offset = offset + MANTX_BATCH_LEN_PREFIX;
+            if (inputLen - span.offset < span.len) {
+                fprintf(stderr, "truncated transaction at offset %zu\n", offset);
+                return false;
+            }
+            offset = span.offset + span.len;
+        }
+
+        if (*count == cap) {
+            cap *= 2;
+            span_t *grown = realloc(*spans, cap * sizeof(span_t));
+            if (grown == NULL) {
+                return false;
+            }
+            *spans = grown;
+        }
+        (*spans)[(*count)++] = span;
+    }
+    return true;
+}
+
+static uint32_t errorKind(parser_error_t err) {
+    return err < INSPECT_ERROR_KINDS ? err : parser_unexpected_error;
+}
+
+// Prints every item, a failing one is printed with its error
+// \return the first error
+static parser_error_t printItems(const parser_context_t *ctx, size_t txIdx, outbuf_t *out) {
+    parser_error_t first = parser_ok;
+    uint8_t numItems = 0;
+    parser_getNumItems(ctx, &numItems);
+    char key[INSPECT_KEY_LEN];
+    char value[INSPECT_VALUE_LEN];
+    for (uint8_t idx = 0; idx < numItems; idx++) {
+        uint8_t pageCount = 1;
+        for (uint8_t page = 0; page < pageCount; page++) {
+            const parser_error_t err = parser_getItem(ctx, idx, key, sizeof(key), value, sizeof(value), page, &pageCount);
+            if (err != parser_ok) {
+                outbuf_printf(out, "%zu\t%u\t%s\t%s\n", txIdx, idx, key, parser_getErrorDescription(err));
+                first = first == parser_ok ? err : first;
+                break;
+            }
+            if (pageCount > 1) {
+                outbuf_printf(out, "%zu\t%u\t%s [%u/%u]\t%s\n", txIdx, idx, key, page + 1, pageCount, value);
+            } else {
+                outbuf_printf(out, "%zu\t%u\t%s\t%s\n", txIdx, idx, key, value);
+            }
+        }
+    }
+    return first;
+}
+
+static void inspectTx(worker_t *worker, size_t txIdx, outbuf_t *out, uint8_t *txBuffer) {
+    const job_t *job = worker->job;
+    const span_t *span = &job->spans[txIdx];
+    const uint8_t *tx = job->input + span->offset;
+    size_t txLen = span->len;
+
+    parser_error_t err = parser_ok;
+    if (job->hex) {
+        const bool decoded = hex_decode((const char *) tx, txLen, txBuffer, INSPECT_MAX_TX_LEN, &txLen);
+        err = decoded ? parser_ok : parser_unexpected_characters;
+        tx = txBuffer;
+    }
+
+    parser_context_t ctx = {0};
+    if (err == parser_ok) {
+        err = parser_parse(&ctx, tx, txLen);
+    }
+    if (err == parser_ok) {
+        err = parser_validate(&ctx);
+    }
+
+    worker->stats.txs++;
+    worker->stats.bytes += txLen;
+    if (err != parser_ok) {
+        worker->stats.errors[errorKind(err)]++;
+        outbuf_printf(out, "%zu\terror\t%s\n", txIdx, parser_getErrorDescription(err));
+        return;
+    }
+    if (!job->summary) {
+        err = printItems(&ctx, txIdx, out);
+    }
+    worker->stats.errors[errorKind(err)]++;
+}
+
+static void *workerMain(void *arg) {
+    worker_t *worker = (worker_t *) arg;
+    job_t *job = worker->job;
+    uint8_t *txBuffer = job->hex ? malloc(INSPECT_MAX_TX_LEN) : NULL;
+
+    while (true) {
+        const size_t chunk = atomic_fetch_add(&job->nextChunk, 1);
+        if (chunk >= job->chunks) {
+            break;
+        }
+        const size_t first = chunk * INSPECT_CHUNK_TXS;
+        const size_t last = first + INSPECT_CHUNK_TXS < job->count ? first + INSPECT_CHUNK_TXS : job->count;
+        for (size_t i = first; i < last; i++) {
+            inspectTx(worker, i, &job->outputs[chunk], txBuffer);
+        }
+
+        pthread_mutex_lock(&job->lock);
+        job->done[chunk] = true;
+        pthread_cond_signal(&job->chunkDone);
+        pthread_mutex_unlock(&job->lock);
+    }
+
+    free(txBuffer);
+    return NULL;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--hex] [--summary] [--threads N] FILE\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    bool hex = false;
+    bool summary = false;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--hex") == 0) {
+            hex = true;
+        } else if (strcmp(argv[i], "--summary") == 0) {
+            summary = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = strtol(argv[++i], NULL, 10);
+        } else if (path == NULL && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path == NULL || threads < 1 || threads > (long) INSPECT_MAX_THREADS) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        return 1;
+    }
+    const size_t inputLen = (size_t) st.st_size;
+    const uint8_t *input = NULL;
+    if (inputLen > 0) {
+        input = mmap(NULL, inputLen, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (input == MAP_FAILED) {
+            perror(path);
+            return 1;
+        }
+        madvise((void *) input, inputLen, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    job_t job = {.input = input, .hex = hex, .summary = summary};
+    span_t *spans = NULL;
+    if (!readSpans(input, inputLen, hex, &spans, &job.count)) {
+        return 1;
+    }
+    job.spans = spans;
+    job.chunks = (job.count + INSPECT_CHUNK_TXS - 1) / INSPECT_CHUNK_TXS;
+    atomic_init(&job.nextChunk, 0);
+    job.outputs = calloc(job.chunks + 1, sizeof(outbuf_t));
+    job.done = calloc(job.chunks + 1, sizeof(bool));
+    if (job.outputs == NULL || job.done == NULL) {
+        return 1;
+    }
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.chunkDone, NULL);
+
+    worker_t workers[INSPECT_MAX_THREADS];
+    pthread_t tids[INSPECT_MAX_THREADS];
+    memset(workers, 0, sizeof(workers));
+    long started = 0;
+    for (; started < threads; started++) {
+        workers[started].job = &job;
+        if (pthread_create(&tids[started], NULL, workerMain, &workers[started]) != 0) {
+            fprintf(stderr, "started %ld of %ld threads\n", started, threads);
+            break;
+        }
+    }
+    // Without any worker thread, the main thread does all the work first
+    const long used = started > 0 ? started : 1;
+    if (started == 0) {
+        workerMain(&workers[0]);
+    }
+
+    // Chunks are written in input order as soon as they are ready
+    for (size_t chunk = 0; chunk < job.chunks; chunk++) {
+        pthread_mutex_lock(&job.lock);
+        while (!job.done[chunk]) {
+            pthread_cond_wait(&job.chunkDone, &job.lock);
+        }
+        pthread_mutex_unlock(&job.lock);
+        if (job.outputs[chunk].len > 0) {
+            fwrite(job.outputs[chunk].data, 1, job.outputs[chunk].len, stdout);
+        }
+        free(job.outputs[chunk].data);
+    }
+
+    stats_t total;
+    memset(&total, 0, sizeof(total));
+    for (long t = 0; t < used; t++) {
+        if (t < started) {
+            pthread_join(tids[t], NULL);
+        }
+        total.txs += workers[t].stats.txs;
+        total.bytes += workers[t].stats.bytes;
+        for (uint32_t e = 0; e < INSPECT_ERROR_KINDS; e++) {
+            total.errors[e] += workers[t].stats.errors[e];
+        }
+    }
+
+    fprintf(stderr, "transactions: %llu\nbytes: %llu\n",
+            (unsigned long long) total.txs, (unsigned long long) total.bytes);
+    for (uint32_t e = 0; e < INSPECT_ERROR_KINDS; e++) {
+        if (total.errors[e] > 0) {
+            fprintf(stderr, "%s: %llu\n", parser_getErrorDescription((parser_error_t) e),
+                    (unsigned long long) total.errors[e]);
+        }
+    }
+
+    free(spans);
+    free(job.outputs);
+    free(job.done);
+    if (input != NULL) {
+        munmap((void *) input, inputLen);
+    }
+    return total.errors[parser_ok] == total.txs ? 0 : 3;
+}
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+# *******************************************************************************
+# *  (c) 2018 - 2023 Zondax AG
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+"""Decodes a trace_dump file (see app/src/trace.h) into one line per record."""
+
+import struct
+import sys
+
+MAGIC = b"MANTRACE"
+VERSION = 1
+RECORD = struct.Struct("<HHIII")
+
+# Keep in sync with trace_event_e, trace_file_e and parser_error_t
+EVENTS = {1: "rlp_read", 2: "read", 3: "read_fields", 4: "get_item", 5: "check_error"}
+FILES = {0: "other", 1: "rlp.c", 2: "parser_impl.c", 3: "parser.c"}
+ERRORS = [
+    "ok", "no_data", "init_context_empty", "display_idx_out_of_range", "display_page_out_of_range",
+    "unexpected_error", "unexpected_type", "unexpected_method", "unexpected_buffer_end",
+    "unexpected_unparsed_bytes", "unexpected_value", "unexpected_number_items", "unexpected_version",
+    "unexpected_characters", "unexpected_field", "duplicated_field", "value_out_of_range",
+    "invalid_address", "unexpected_chain", "missing_field", "unknown_transaction", "scratch_exhausted",
+    "rlp_too_deep", "budget_exhausted",
+]
+
+
+def error_name(code):
+    return ERRORS[code] if code < len(ERRORS) else "error_%d" % code
+
+
+def describe(event, error, offset, length):
+    name = EVENTS.get(event, "event_%d" % event)
+    if name == "check_error":
+        return "%-12s %s at %s:%d" % (name, error_name(error), FILES.get(length, "file_%d" % length), offset)
+    if name == "get_item":
+        return "%-12s item %d page %d -> %s" % (name, offset, length, error_name(error))
+    return "%-12s offset %d len %d -> %s" % (name, offset, length, error_name(error))
+
+
+def main(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:len(MAGIC)] != MAGIC:
+        sys.exit("%s: not a trace dump" % path)
+    version, count = struct.unpack_from("<II", data, len(MAGIC))
+    if version != VERSION:
+        sys.exit("%s: unsupported version %d" % (path, version))
+
+    offset = len(MAGIC) + 8
+    for _ in range(count):
+        event, error, field_offset, length, seq = RECORD.unpack_from(data, offset)
+        offset += RECORD.size
+        print("%10d  %s" % (seq, describe(event, error, field_offset, length)))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.exit("usage: %s TRACE_FILE" % sys.argv[0])
+    main(sys.argv[1])
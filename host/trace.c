@@ -0,0 +1,77 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "trace.h"
+#include "host_build.h"
+
+#include <stdio.h>
+#include <string.h>
+
+_Static_assert((TRACE_CAPACITY & (TRACE_CAPACITY - 1)) == 0, "TRACE_CAPACITY must be a power of two");
+_Static_assert(sizeof(trace_record_t) == 16, "trace record layout");
+
+// Only the owning thread touches its ring, no synchronisation needed
+static APP_THREAD_LOCAL trace_record_t ring[TRACE_CAPACITY];
+static APP_THREAD_LOCAL uint32_t ring_seq = 0;
+
+void trace_record(uint16_t event, uint32_t offset, uint32_t len, uint16_t error) {
+    trace_record_t *r = &ring[ring_seq & (TRACE_CAPACITY - 1)];
+    r->event = event;
+    r->error = error;
+    r->offset = offset;
+    r->len = len;
+    r->seq = ring_seq++;
+}
+
+size_t trace_snapshot(trace_record_t *records, size_t maxRecords) {
+    if (records == NULL) {
+        return 0;
+    }
+    size_t count = ring_seq < TRACE_CAPACITY ? ring_seq : TRACE_CAPACITY;
+    if (count > maxRecords) {
+        count = maxRecords;
+    }
+    // The newest `count` records, oldest first
+    const uint32_t first = ring_seq - (uint32_t) count;
+    for (size_t i = 0; i < count; i++) {
+        records[i] = ring[(first + i) & (TRACE_CAPACITY - 1)];
+    }
+    return count;
+}
+
+void trace_reset(void) {
+    memset(ring, 0, sizeof(ring));
+    ring_seq = 0;
+}
+
+int trace_dump(const char *path) {
+    static APP_THREAD_LOCAL trace_record_t records[TRACE_CAPACITY];
+    if (path == NULL) {
+        return -1;
+    }
+    const uint32_t count = (uint32_t) trace_snapshot(records, TRACE_CAPACITY);
+    const uint32_t version = TRACE_VERSION;
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        return -1;
+    }
+    int ok = fwrite(TRACE_MAGIC, TRACE_MAGIC_LEN, 1, f) == 1 &&
+             fwrite(&version, sizeof(version), 1, f) == 1 &&
+             fwrite(&count, sizeof(count), 1, f) == 1 &&
+             (count == 0 || fwrite(records, sizeof(trace_record_t), count, f) == count);
+    ok = fclose(f) == 0 && ok;
+    return ok ? 0 : -1;
+}
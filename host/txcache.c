@@ -0,0 +1,227 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "txcache.h"
+#include "keccak.h"
+#include "parser.h"
+
+#include <string.h>
+
+// Keccak output is uniform: one byte picks the shard, four more the home slot
+static txcache_shard_t *shardOf(txcache_t *cache, const uint8_t *hash) {
+    return &cache->shards[hash[0] % TXCACHE_SHARDS];
+}
+
+static uint32_t homeOf(const txcache_shard_t *shard, const uint8_t *hash) {
+    const uint32_t h = (uint32_t) hash[1] | ((uint32_t) hash[2] << 8u) |
+                       ((uint32_t) hash[3] << 16u) | ((uint32_t) hash[4] << 24u);
+    return h % shard->count;
+}
+
+static uint32_t probeOf(const txcache_shard_t *shard) {
+    return shard->count < TXCACHE_PROBE ? shard->count : TXCACHE_PROBE;
+}
+
+static txcache_slot_t *find(txcache_shard_t *shard, const uint8_t *hash, uint32_t *slotIdx) {
+    const uint32_t home = homeOf(shard, hash);
+    const uint32_t probe = probeOf(shard);
+    for (uint32_t i = 0; i < probe; i++) {
+        const uint32_t idx = (home + i) % shard->count;
+        txcache_slot_t *slot = &shard->slots[idx];
+        if (slot->used && memcmp(slot->hash, hash, KECCAK_HASH_SIZE) == 0) {
+            *slotIdx = idx;
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+// A free slot in the probe window or, failing that, the CLOCK victim: the hand
+// clears reference bits until it reaches a slot that was not hit since
+static uint32_t claim(txcache_shard_t *shard, const uint8_t *hash) {
+    const uint32_t home = homeOf(shard, hash);
+    const uint32_t probe = probeOf(shard);
+    for (uint32_t i = 0; i < probe; i++) {
+        const uint32_t idx = (home + i) % shard->count;
+        if (!shard->slots[idx].used) {
+            return idx;
+        }
+    }
+
+    shard->stats.evictions++;
+    for (;;) {
+        const uint32_t idx = (home + shard->hand % probe) % shard->count;
+        shard->hand++;
+        if (!shard->slots[idx].referenced) {
+            return idx;
+        }
+        shard->slots[idx].referenced = 0;
+    }
+}
+
+zxerr_t txcache_init(txcache_t *cache, txcache_slot_t *slots, uint32_t count,
+                     uint8_t *rendered, uint32_t renderSlotLen) {
+    if (cache == NULL || slots == NULL || count < TXCACHE_SHARDS) {
+        return zxerr_unknown;
+    }
+    if (rendered == NULL) {
+        renderSlotLen = 0;
+    }
+
+    memset(slots, 0, sizeof(txcache_slot_t) * count);
+    cache->renderSlotLen = renderSlotLen;
+
+    // Spread the remainder over the first shards
+    const uint32_t perShard = count / TXCACHE_SHARDS;
+    const uint32_t extra = count % TXCACHE_SHARDS;
+    uint32_t first = 0;
+    for (uint32_t i = 0; i < TXCACHE_SHARDS; i++) {
+        txcache_shard_t *shard = &cache->shards[i];
+        pthread_mutex_init(&shard->lock, NULL);
+        shard->slots = slots + first;
+        shard->rendered = renderSlotLen > 0 ? rendered + (size_t) first * renderSlotLen : NULL;
+        shard->count = perShard + (i < extra ? 1 : 0);
+        shard->hand = 0;
+        memset(&shard->stats, 0, sizeof(shard->stats));
+        first += shard->count;
+    }
+    return zxerr_ok;
+}
+
+void txcache_destroy(txcache_t *cache) {
+    if (cache == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < TXCACHE_SHARDS; i++) {
+        pthread_mutex_destroy(&cache->shards[i].lock);
+    }
+}
+
+zxerr_t txcache_hash(const uint8_t *blob, size_t blobLen, uint8_t hash[KECCAK_HASH_SIZE]) {
+    if (blob == NULL || hash == NULL || blobLen > UINT32_MAX) {
+        return zxerr_unknown;
+    }
+    return keccak_hash(blob, (unsigned int) blobLen, hash, KECCAK_HASH_SIZE);
+}
+
+bool txcache_get(txcache_t *cache, const uint8_t hash[KECCAK_HASH_SIZE],
+                 txcache_entry_t *entry, uint8_t *rendered, uint32_t renderedMax) {
+    if (cache == NULL || hash == NULL || entry == NULL) {
+        return false;
+    }
+
+    txcache_shard_t *shard = shardOf(cache, hash);
+    pthread_mutex_lock(&shard->lock);
+    uint32_t idx = 0;
+    txcache_slot_t *slot = find(shard, hash, &idx);
+    if (slot == NULL) {
+        shard->stats.misses++;
+        pthread_mutex_unlock(&shard->lock);
+        return false;
+    }
+
+    shard->stats.hits++;
+    slot->referenced = 1;
+    entry->parseError = (parser_error_t) slot->parseError;
+    entry->validateError = (parser_error_t) slot->validateError;
+    entry->renderedLen = 0;
+    if (rendered != NULL && slot->renderedLen > 0 && slot->renderedLen <= renderedMax) {
+        memcpy(rendered, shard->rendered + (size_t) idx * cache->renderSlotLen, slot->renderedLen);
+        entry->renderedLen = slot->renderedLen;
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return true;
+}
+
+void txcache_put(txcache_t *cache, const uint8_t hash[KECCAK_HASH_SIZE],
+                 parser_error_t parseError, parser_error_t validateError,
+                 const uint8_t *rendered, uint32_t renderedLen) {
+    if (cache == NULL || hash == NULL) {
+        return;
+    }
+    if (rendered == NULL || renderedLen > cache->renderSlotLen) {
+        renderedLen = 0;
+    }
+
+    txcache_shard_t *shard = shardOf(cache, hash);
+    pthread_mutex_lock(&shard->lock);
+    uint32_t idx = 0;
+    txcache_slot_t *slot = find(shard, hash, &idx);
+    if (slot == NULL) {
+        idx = claim(shard, hash);
+        slot = &shard->slots[idx];
+        memcpy(slot->hash, hash, KECCAK_HASH_SIZE);
+        slot->used = 1;
+        slot->referenced = 0;
+        shard->stats.inserts++;
+    }
+
+    slot->parseError = (uint16_t) parseError;
+    slot->validateError = (uint16_t) validateError;
+    slot->renderedLen = renderedLen;
+    if (renderedLen > 0) {
+        memcpy(shard->rendered + (size_t) idx * cache->renderSlotLen, rendered, renderedLen);
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+parser_error_t txcache_check(txcache_t *cache, const uint8_t *blob, size_t blobLen, txcache_entry_t *entry) {
+    if (cache == NULL || entry == NULL) {
+        return parser_unexpected_error;
+    }
+
+    if (blob == NULL || blobLen == 0) {
+        return parser_init_context_empty;
+    }
+    // parser_parse takes a uint16_t length, a longer blob would be parsed truncated
+    if (blobLen > UINT16_MAX) {
+        entry->parseError = parser_value_out_of_range;
+        entry->validateError = parser_no_data;
+        entry->renderedLen = 0;
+        return parser_value_out_of_range;
+    }
+    uint8_t hash[KECCAK_HASH_SIZE];
+    if (txcache_hash(blob, blobLen, hash) != zxerr_ok) {
+        return parser_unexpected_error;
+    }
+
+    if (!txcache_get(cache, hash, entry, NULL, 0)) {
+        parser_context_t ctx;
+        entry->parseError = parser_parse(&ctx, blob, (uint16_t) blobLen);
+        entry->validateError = entry->parseError == parser_ok ? parser_validate(&ctx) : parser_no_data;
+        entry->renderedLen = 0;
+        txcache_put(cache, hash, entry->parseError, entry->validateError, NULL, 0);
+    }
+    return entry->parseError != parser_ok ? entry->parseError : entry->validateError;
+}
+
+void txcache_stats(txcache_t *cache, txcache_stats_t *stats) {
+    if (stats == NULL) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (cache == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < TXCACHE_SHARDS; i++) {
+        txcache_shard_t *shard = &cache->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        stats->hits += shard->stats.hits;
+        stats->misses += shard->stats.misses;
+        stats->inserts += shard->stats.inserts;
+        stats->evictions += shard->stats.evictions;
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
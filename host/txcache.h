@@ -0,0 +1,104 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "coin.h"
+#include "parser_common.h"
+#include "zxerror.h"
+
+// Host only: remembers parse and validation results by transaction hash, so
+// services that see the same blob again skip parsing and rendering.
+// Slots are split into shards, each behind its own lock. A key lives within
+// TXCACHE_PROBE slots of its home slot; when they are all taken, a CLOCK hand
+// evicts the first one not used since it last went by.
+
+#define TXCACHE_SHARDS  16u
+#define TXCACHE_PROBE   8u
+
+typedef struct {
+    uint8_t hash[KECCAK_HASH_SIZE];
+    uint8_t used;
+    uint8_t referenced;             // CLOCK bit, set by every hit
+    uint16_t parseError;            // parser_error_t
+    uint16_t validateError;         // parser_error_t, parser_no_data when not validated
+    uint32_t renderedLen;           // 0 when the rendered items were not stored
+} txcache_slot_t;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t inserts;
+    uint64_t evictions;
+} txcache_stats_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    txcache_slot_t *slots;
+    uint8_t *rendered;              // renderSlotLen bytes per slot, NULL when not kept
+    uint32_t count;
+    uint32_t hand;
+    txcache_stats_t stats;
+} txcache_shard_t;
+
+typedef struct {
+    txcache_shard_t shards[TXCACHE_SHARDS];
+    uint32_t renderSlotLen;
+} txcache_t;
+
+typedef struct {
+    parser_error_t parseError;
+    parser_error_t validateError;
+    uint32_t renderedLen;           // bytes copied out, 0 when none were stored
+} txcache_entry_t;
+
+/// slots (count entries) and rendered (count * renderSlotLen bytes, optional) are caller owned.
+/// count must be at least TXCACHE_SHARDS.
+zxerr_t txcache_init(txcache_t *cache, txcache_slot_t *slots, uint32_t count,
+                     uint8_t *rendered, uint32_t renderSlotLen);
+void txcache_destroy(txcache_t *cache);
+
+/// Keccak-256 of the blob, the cache key
+zxerr_t txcache_hash(const uint8_t *blob, size_t blobLen, uint8_t hash[KECCAK_HASH_SIZE]);
+
+/// Copies a cached result and, if stored and it fits in renderedMax, its rendered items
+/// \return false on a miss
+bool txcache_get(txcache_t *cache, const uint8_t hash[KECCAK_HASH_SIZE],
+                 txcache_entry_t *entry, uint8_t *rendered, uint32_t renderedMax);
+
+/// Stores or replaces a result. Rendered items longer than the cache's renderSlotLen are dropped.
+void txcache_put(txcache_t *cache, const uint8_t hash[KECCAK_HASH_SIZE],
+                 parser_error_t parseError, parser_error_t validateError,
+                 const uint8_t *rendered, uint32_t renderedLen);
+
+/// Parses and validates blob through the cache, entry gets both results.
+/// Blobs longer than UINT16_MAX are rejected without being cached.
+/// \return the parse error or, once parsed, the validation error
+parser_error_t txcache_check(txcache_t *cache, const uint8_t *blob, size_t blobLen, txcache_entry_t *entry);
+
+/// Sums the counters of every shard
+void txcache_stats(txcache_t *cache, txcache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,199 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "txindex.h"
+#include "parser_impl.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The file layout is the in-memory layout, keep it free of padding surprises
+_Static_assert(sizeof(txindex_header_t) == 16, "txindex header layout");
+_Static_assert(sizeof(txindex_record_t) == 152, "txindex record layout");
+
+static void encodeNode(txindex_record_t *record, uint8_t node, const rlp_t *rlp, const uint8_t *blob) {
+    record->kinds[node] = (uint8_t) rlp->kind;
+    record->nodes[node].offset = (uint16_t) (rlp->ptr - blob);
+    record->nodes[node].len = (uint16_t) rlp->rlpLen;
+}
+
+static parser_error_t viewNode(const txindex_record_t *record, uint8_t node,
+                               const uint8_t *blob, uint16_t blobLen, rlp_t *rlp) {
+    const txindex_node_t *n = &record->nodes[node];
+    const uint8_t kind = record->kinds[node];
+    if (kind > RLP_KIND_LIST) {
+        return parser_unexpected_type;
+    }
+    // Single bytes point at their prefix and have no length
+    const uint32_t end = (uint32_t) n->offset + (kind == RLP_KIND_BYTE ? 1u : n->len);
+    if (end > blobLen) {
+        return parser_unexpected_buffer_end;
+    }
+    rlp->kind = (rlp_kind_e) kind;
+    rlp->ptr = blob + n->offset;
+    rlp->rlpLen = n->len;
+    return parser_ok;
+}
+
+void txindex_encode(const uint8_t *blob, uint16_t blobLen, uint64_t blobOffset, txindex_record_t *record) {
+    if (record == NULL) {
+        return;
+    }
+    MEMZERO(record, sizeof(*record));
+    record->blobOffset = blobOffset;
+    record->blobLen = blobLen;
+    if (blob == NULL) {
+        record->status = parser_no_data;
+        return;
+    }
+
+    parser_tx_t tx;
+    MEMZERO(&tx, sizeof(tx));
+    parser_context_t ctx = {.buffer = blob, .bufferLen = blobLen, .offset = 0, .tx_obj = &tx};
+    record->status = (uint8_t) _read(&ctx, &tx);
+    if (record->status != parser_ok) {
+        return;
+    }
+
+    record->txType = tx.extraTxType;
+    record->extraFieldsItems = (uint8_t) tx.extraFieldsItems;
+    record->extraToFieldsItems = (uint8_t) tx.extraToFieldsItems;
+    encodeNode(record, TXINDEX_NODE_ROOT, &tx.root, blob);
+    for (uint8_t i = 0; i < MANTX_ROOTFIELD_COUNT; i++) {
+        encodeNode(record, TXINDEX_NODE_FIELDS + i, &tx.fields[i], blob);
+    }
+    for (uint8_t i = 0; i < tx.extraFieldsItems; i++) {
+        encodeNode(record, TXINDEX_NODE_EXTRA + i, &tx.extraFields[i], blob);
+    }
+    for (uint8_t i = 0; i < tx.extraToFieldsItems; i++) {
+        encodeNode(record, TXINDEX_NODE_TO + i, &tx.extraToListFields[i], blob);
+    }
+}
+
+zxerr_t txindex_writeFile(const char *path, const txindex_record_t *records, uint32_t count) {
+    if (path == NULL || (records == NULL && count > 0)) {
+        return zxerr_unknown;
+    }
+
+    txindex_header_t header;
+    MEMZERO(&header, sizeof(header));
+    memcpy(header.magic, TXINDEX_MAGIC, TXINDEX_MAGIC_LEN);
+    header.version = TXINDEX_VERSION;
+    header.recordSize = sizeof(txindex_record_t);
+    header.count = count;
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        return zxerr_unknown;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    if (ok && count > 0) {
+        ok = fwrite(records, sizeof(txindex_record_t), count, f) == count;
+    }
+    ok = (fclose(f) == 0) && ok;
+    return ok ? zxerr_ok : zxerr_unknown;
+}
+
+zxerr_t txindex_open(txindex_t *index, const char *path) {
+    if (index == NULL || path == NULL) {
+        return zxerr_unknown;
+    }
+    MEMZERO(index, sizeof(*index));
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return zxerr_no_data;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(txindex_header_t)) {
+        close(fd);
+        return zxerr_no_data;
+    }
+    void *map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return zxerr_unknown;
+    }
+
+    const txindex_header_t *header = (const txindex_header_t *) map;
+    const uint64_t expected = sizeof(txindex_header_t) + (uint64_t) header->count * sizeof(txindex_record_t);
+    if (memcmp(header->magic, TXINDEX_MAGIC, TXINDEX_MAGIC_LEN) != 0 ||
+        header->version != TXINDEX_VERSION ||
+        header->recordSize != sizeof(txindex_record_t) ||
+        expected != (uint64_t) st.st_size) {
+        munmap(map, (size_t) st.st_size);
+        return zxerr_encoding_failed;
+    }
+
+    index->map = map;
+    index->mapLen = (size_t) st.st_size;
+    index->header = header;
+    index->records = (const txindex_record_t *) (header + 1);
+    index->count = header->count;
+    return zxerr_ok;
+}
+
+void txindex_close(txindex_t *index) {
+    if (index == NULL) {
+        return;
+    }
+    if (index->map != NULL) {
+        munmap(index->map, index->mapLen);
+    }
+    MEMZERO(index, sizeof(*index));
+}
+
+const txindex_record_t *txindex_get(const txindex_t *index, uint32_t idx) {
+    if (index == NULL || idx >= index->count) {
+        return NULL;
+    }
+    return &index->records[idx];
+}
+
+parser_error_t txindex_view(const txindex_record_t *record, const uint8_t *blob, uint16_t blobLen, parser_tx_t *tx) {
+    if (record == NULL || blob == NULL || tx == NULL) {
+        return parser_unexpected_error;
+    }
+    if (record->status != parser_ok) {
+        return (parser_error_t) record->status;
+    }
+    if (record->blobLen != blobLen ||
+        record->extraFieldsItems > MANTX_EXTRAFIELD_COUNT ||
+        record->extraToFieldsItems > MANTX_EXTRALISTFIELD_COUNT) {
+        return parser_unexpected_value;
+    }
+
+    MEMZERO(tx, sizeof(*tx));
+    CHECK_ERROR(viewNode(record, TXINDEX_NODE_ROOT, blob, blobLen, &tx->root))
+    for (uint8_t i = 0; i < MANTX_ROOTFIELD_COUNT; i++) {
+        CHECK_ERROR(viewNode(record, TXINDEX_NODE_FIELDS + i, blob, blobLen, &tx->fields[i]))
+    }
+    for (uint8_t i = 0; i < record->extraFieldsItems; i++) {
+        CHECK_ERROR(viewNode(record, TXINDEX_NODE_EXTRA + i, blob, blobLen, &tx->extraFields[i]))
+    }
+    for (uint8_t i = 0; i < record->extraToFieldsItems; i++) {
+        CHECK_ERROR(viewNode(record, TXINDEX_NODE_TO + i, blob, blobLen, &tx->extraToListFields[i]))
+    }
+    tx->rootFieldsItems = MANTX_ROOTFIELD_COUNT;
+    tx->extraFieldsItems = record->extraFieldsItems;
+    tx->extraToFieldsItems = record->extraToFieldsItems;
+    tx->extraTxType = record->txType;
+    return parser_ok;
+}
@@ -0,0 +1,98 @@
+/*******************************************************************************
+*  (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "parser_common.h"
+#include "parser_txdef.h"
+#include "zxerror.h"
+
+// Host only: parse index sidecar. One fixed size record per transaction keeps the
+// spans _read found, so a parser_tx_t can be rebuilt over the blob without parsing.
+//
+// File layout (host byte order, little endian in practice):
+//   txindex_header_t
+//   txindex_record_t[count]
+
+#define TXINDEX_MAGIC       "MANTXIDX"
+#define TXINDEX_MAGIC_LEN   8u
+#define TXINDEX_VERSION     1u
+
+// root, root fields, extra fields, recipient lists
+#define TXINDEX_NODE_ROOT   0u
+#define TXINDEX_NODE_FIELDS (TXINDEX_NODE_ROOT + 1u)
+#define TXINDEX_NODE_EXTRA  (TXINDEX_NODE_FIELDS + MANTX_ROOTFIELD_COUNT)
+#define TXINDEX_NODE_TO     (TXINDEX_NODE_EXTRA + MANTX_EXTRAFIELD_COUNT)
+#define TXINDEX_NODES       (TXINDEX_NODE_TO + MANTX_EXTRALISTFIELD_COUNT)
+
+typedef struct {
+    char magic[TXINDEX_MAGIC_LEN];
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t count;
+} txindex_header_t;
+
+/// Payload span relative to the start of the transaction
+typedef struct {
+    uint16_t offset;
+    uint16_t len;
+} txindex_node_t;
+
+typedef struct {
+    uint64_t blobOffset;                // where the transaction starts in the blob file
+    uint16_t blobLen;
+    uint8_t status;                     // parser_error_t returned by _read
+    uint8_t txType;
+    uint8_t extraFieldsItems;
+    uint8_t extraToFieldsItems;
+    uint8_t kinds[TXINDEX_NODES];       // rlp_kind_e of every node
+    uint8_t reserved[3];
+    txindex_node_t nodes[TXINDEX_NODES];
+} txindex_record_t;
+
+/// Read only view over a mapped index file
+typedef struct {
+    const txindex_header_t *header;
+    const txindex_record_t *records;
+    uint32_t count;
+    void *map;
+    size_t mapLen;
+} txindex_t;
+
+/// Parses blob with _read and records the result, failures only keep their status
+void txindex_encode(const uint8_t *blob, uint16_t blobLen, uint64_t blobOffset, txindex_record_t *record);
+
+zxerr_t txindex_writeFile(const char *path, const txindex_record_t *records, uint32_t count);
+
+/// Maps path read only, rejects a wrong magic, version, record size or file length
+zxerr_t txindex_open(txindex_t *index, const char *path);
+void txindex_close(txindex_t *index);
+
+/// \return NULL when idx is out of range
+const txindex_record_t *txindex_get(const txindex_t *index, uint32_t idx);
+
+/// Rebuilds tx over blob from record. Spans are bounds checked against blob.
+/// \return the status stored when indexing (tx is only filled when it is parser_ok)
+parser_error_t txindex_view(const txindex_record_t *record, const uint8_t *blob, uint16_t blobLen, parser_tx_t *tx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,3 +6,6 @@ export const P2_VALUES = {
 
 export const PKLEN = 65;
 export const RSV_SIGNATURE_LEN = 65;
+
+export const P1_BATCH_GET_SIGNATURE = 0x03;
+export const BATCH_MAX_TRANSACTIONS = 8;
@@ -14,8 +14,8 @@
  *  See the License for the specific language governing permissions and
  *  limitations under the License.
  ******************************************************************************* */
-import { P2_VALUES, RSV_SIGNATURE_LEN } from "./consts";
-import { ResponseAddress, ResponseSign, TemplateIns } from "./types";
+import { BATCH_MAX_TRANSACTIONS, P1_BATCH_GET_SIGNATURE, P2_VALUES, RSV_SIGNATURE_LEN } from "./consts";
+import { ResponseAddress, ResponseSign, ResponseSignBatch, TemplateIns } from "./types";
 
 import GenericApp, {
   ConstructorParams,
@@ -41,6 +41,8 @@ export default class MatrixAIApp extends GenericApp {
         GET_VERSION: 0x00,
         GET_ADDR: 0x01,
         SIGN: 0x02,
+        SIGN_BATCH: 0x03,
+        SIGN_ONESHOT: 0x04,
       },
       p1Values: {
         ONLY_RETRIEVE: 0x00,
@@ -71,7 +73,7 @@ export default class MatrixAIApp extends GenericApp {
       .then(processGetAddrResponse, processErrorResponse);
   }
 
-  async signSendChunk(chunkIdx: number, chunkNum: number, chunk: Buffer): Promise<ResponseSign> {
+  async signSendChunk(chunkIdx: number, chunkNum: number, chunk: Buffer, ins: number = this.INS.SIGN): Promise<ResponseSign> {
     let payloadType = PAYLOAD_TYPE.ADD;
     if (chunkIdx === 1) {
       payloadType = PAYLOAD_TYPE.INIT;
@@ -81,7 +83,7 @@ export default class MatrixAIApp extends GenericApp {
     }
 
     return await this.transport
-      .send(this.CLA, this.INS.SIGN, payloadType, P2_VALUES.DEFAULT, chunk, [
+      .send(this.CLA, ins, payloadType, P2_VALUES.DEFAULT, chunk, [
         LedgerError.NoErrors,
         LedgerError.DataIsInvalid,
         LedgerError.BadKeyHandle,
@@ -139,4 +141,75 @@ export default class MatrixAIApp extends GenericApp {
       return result;
     }, processErrorResponse);
   }
+
+  async signOneShot(path: string, message: Buffer): Promise<ResponseSign> {
+    // Path and message travel together, use sign() when they do not fit in a single APDU
+    const payload = Buffer.concat([this.serializePath(path), message]);
+    if (payload.length > this.CHUNK_SIZE) {
+      throw new Error(`Message too long for a single APDU (max ${this.CHUNK_SIZE} bytes including path)`);
+    }
+
+    return await this.signSendChunk(1, 1, payload, this.INS.SIGN_ONESHOT);
+  }
+
+  async signBatchGetSignature(txIdx: number): Promise<ResponseSign> {
+    return await this.transport
+      .send(this.CLA, this.INS.SIGN_BATCH, P1_BATCH_GET_SIGNATURE, txIdx, Buffer.alloc(0), [
+        LedgerError.NoErrors,
+        LedgerError.DataIsInvalid,
+        LedgerError.SignVerifyError,
+      ])
+      .then((response: Buffer) => {
+        const errorCodeData = response.subarray(-2);
+        const returnCode = errorCodeData[0] * 256 + errorCodeData[1];
+
+        if (returnCode !== LedgerError.NoErrors) {
+          return { returnCode, errorMessage: errorCodeToString(returnCode) };
+        }
+
+        return {
+          signatureRSV: response.subarray(0, RSV_SIGNATURE_LEN),
+          signatureDER: response.subarray(RSV_SIGNATURE_LEN, response.length - 2),
+          returnCode,
+          errorMessage: errorCodeToString(returnCode),
+        };
+      }, processErrorResponse);
+  }
+
+  async signBatch(path: string, messages: Buffer[]): Promise<ResponseSignBatch> {
+    if (messages.length === 0 || messages.length > BATCH_MAX_TRANSACTIONS) {
+      throw new Error(`Batch must contain between 1 and ${BATCH_MAX_TRANSACTIONS} transactions`);
+    }
+
+    // Every transaction is prefixed by its length (2 bytes, big endian)
+    const packed = Buffer.concat(
+      messages.map((message) => {
+        const len = Buffer.alloc(2);
+        len.writeUInt16BE(message.length);
+        return Buffer.concat([len, message]);
+      }),
+    );
+
+    const chunks = this.prepareChunks(path, packed);
+    let result: ResponseSign = { returnCode: LedgerError.NoErrors, errorMessage: "" };
+    for (let i = 0; i < chunks.length; i += 1) {
+      // eslint-disable-next-line no-await-in-loop
+      result = await this.signSendChunk(1 + i, chunks.length, chunks[i], this.INS.SIGN_BATCH);
+      if (result.returnCode !== LedgerError.NoErrors) {
+        return { returnCode: result.returnCode, errorMessage: result.errorMessage };
+      }
+    }
+
+    const signatures: ResponseSign[] = [];
+    for (let i = 0; i < messages.length; i += 1) {
+      // eslint-disable-next-line no-await-in-loop
+      const signature = await this.signBatchGetSignature(i);
+      if (signature.returnCode !== LedgerError.NoErrors) {
+        return { returnCode: signature.returnCode, errorMessage: signature.errorMessage };
+      }
+      signatures.push(signature);
+    }
+
+    return { signatures, returnCode: LedgerError.NoErrors, errorMessage: errorCodeToString(LedgerError.NoErrors) };
+  }
 }
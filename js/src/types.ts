@@ -4,6 +4,8 @@ export interface TemplateIns extends INSGeneric {
   GET_VERSION: 0x00;
   GET_ADDR: 0x01;
   SIGN: 0x02;
+  SIGN_BATCH: 0x03;
+  SIGN_ONESHOT: 0x04;
 }
 
 export interface ResponseAddress extends ResponseBase {
@@ -15,3 +17,7 @@ export interface ResponseSign extends ResponseBase {
   signatureRSV?: Buffer;
   signatureDER?: Buffer;
 }
+
+export interface ResponseSignBatch extends ResponseBase {
+  signatures?: ResponseSign[];
+}
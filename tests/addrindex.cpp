@@ -0,0 +1,255 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "common.h"
+#include "addrindex.h"
+#include "crypto_helper.h"
+#include "parser_impl.h"
+#include "rlp.h"
+
+using namespace std;
+
+namespace {
+    typedef array<uint8_t, ETH_ADDRESS_LEN> address_t;
+
+    vector<address_t> randomAddresses(size_t count, uint32_t seed) {
+        mt19937 rng(seed);
+        vector<address_t> addresses(count);
+        for (auto &a : addresses) {
+            for (auto &b : a) {
+                b = (uint8_t) rng();
+            }
+        }
+        return addresses;
+    }
+
+    void writeFile(const string &path, const string &content) {
+        FILE *f = fopen(path.c_str(), "w");
+        ASSERT_TRUE(f != nullptr);
+        fwrite(content.data(), 1, content.size(), f);
+        fclose(f);
+    }
+
+    parser_tx_t readTx(const string &hex, vector<uint8_t> &buffer) {
+        buffer = decodeBlob(hex);
+        parser_tx_t tx;
+        EXPECT_THAT(readBlob(buffer, &tx), testing::Eq(parser_ok));
+        return tx;
+    }
+
+    string text(const rlp_t &rlp) {
+        return string((const char *) rlp.ptr, rlp.rlpLen);
+    }
+}
+
+TEST(AddrIndex, MembersAndStrangers) {
+    auto members = randomAddresses(20000, 1);
+    members.push_back(members[0]);
+    const auto strangers = randomAddresses(100000, 2);
+
+    uint8_t *image = nullptr;
+    size_t imageLen = 0;
+    ASSERT_THAT(addrindex_build((const uint8_t (*)[ETH_ADDRESS_LEN]) members.data(), members.size(), &image, &imageLen),
+                testing::Eq(zxerr_ok));
+
+    addrindex_t index;
+    ASSERT_THAT(addrindex_view(&index, image, imageLen), testing::Eq(zxerr_ok));
+    EXPECT_THAT(index.count, testing::Eq(members.size() - 1));
+
+    for (const auto &a : members) {
+        EXPECT_TRUE(addrindex_contains(&index, a.data()));
+    }
+    for (const auto &a : strangers) {
+        EXPECT_FALSE(addrindex_contains(&index, a.data()));
+    }
+
+    // Truncated or altered images are rejected
+    EXPECT_THAT(addrindex_view(&index, image, imageLen - 1), testing::Eq(zxerr_encoding_failed));
+    image[0] ^= 1;
+    EXPECT_THAT(addrindex_view(&index, image, imageLen), testing::Eq(zxerr_encoding_failed));
+    image[0] ^= 1;
+    reinterpret_cast<addrindex_header_t *>(image)->groups++;
+    EXPECT_THAT(addrindex_view(&index, image, imageLen), testing::Eq(zxerr_encoding_failed));
+    free(image);
+
+    // An empty list is a valid index
+    ASSERT_THAT(addrindex_build(nullptr, 0, &image, &imageLen), testing::Eq(zxerr_ok));
+    ASSERT_THAT(addrindex_view(&index, image, imageLen), testing::Eq(zxerr_ok));
+    EXPECT_FALSE(addrindex_contains(&index, members[0].data()));
+    free(image);
+}
+
+TEST(AddrIndex, TransactionsFromAMappedList) {
+    // Every root To of the test vectors, and one recipient of a transaction that has some
+    string list = "# deny list\n\n";
+    string recipientTo;
+    vector<pair<string, uint16_t>> recipients;
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        vector<uint8_t> buffer;
+        const parser_tx_t tx = readTx(tc.blob, buffer);
+        if (tx.fields[MANTX_FIELD_TO].rlpLen > 0) {
+            list += "  " + text(tx.fields[MANTX_FIELD_TO]) + " \r\n";
+        }
+        if (tx.extraToFieldsItems > 1 && recipients.empty()) {
+            rlp_t items[MANTX_EXTRATOFIELD_COUNT];
+            uint16_t itemCount = 0;
+            ASSERT_THAT(rlp_readList(&tx.extraToListFields[1], items, &itemCount, MANTX_EXTRATOFIELD_COUNT),
+                        testing::Eq(parser_ok));
+            recipientTo = text(items[0]);
+            recipients.emplace_back(tc.blob, 1);
+        }
+    }
+    ASSERT_FALSE(recipients.empty());
+
+    const string listPath = tempPath("mantx_addr");
+    const string indexPath = tempPath("mantx_addr");
+    writeFile(listPath, list);
+    uint64_t count = 0;
+    ASSERT_THAT(addrindex_buildFile(listPath.c_str(), indexPath.c_str(), &count, nullptr), testing::Eq(zxerr_ok));
+    EXPECT_THAT(count, testing::Gt(0u));
+
+    addrindex_t index;
+    ASSERT_THAT(addrindex_open(&index, indexPath.c_str()), testing::Eq(zxerr_ok));
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        vector<uint8_t> buffer;
+        const parser_tx_t tx = readTx(tc.blob, buffer);
+        addrindex_match_t match;
+        ASSERT_THAT(addrindex_matchTx(&index, &tx, &match), testing::Eq(parser_ok)) << tc.name;
+        EXPECT_THAT(match.found, testing::Eq(tx.fields[MANTX_FIELD_TO].rlpLen > 0)) << tc.name;
+        EXPECT_THAT(match.recipient, testing::Eq(ADDRINDEX_MATCH_TO));
+    }
+    addrindex_close(&index);
+
+    // Only the recipient listed
+    writeFile(listPath, recipientTo + "\n");
+    ASSERT_THAT(addrindex_buildFile(listPath.c_str(), indexPath.c_str(), &count, nullptr), testing::Eq(zxerr_ok));
+    EXPECT_THAT(count, testing::Eq(1u));
+    ASSERT_THAT(addrindex_open(&index, indexPath.c_str()), testing::Eq(zxerr_ok));
+    {
+        vector<uint8_t> buffer;
+        const parser_tx_t tx = readTx(recipients[0].first, buffer);
+        addrindex_match_t match;
+        ASSERT_THAT(addrindex_matchTx(&index, &tx, &match), testing::Eq(parser_ok));
+        EXPECT_TRUE(match.found);
+        EXPECT_THAT(match.recipient, testing::Eq(recipients[0].second));
+    }
+    addrindex_close(&index);
+
+    // A bad line is reported and nothing is written
+    uint64_t errorLine = 0;
+    writeFile(listPath, recipientTo + "\n# ok\nMAN.notanaddress\n");
+    EXPECT_THAT(addrindex_buildFile(listPath.c_str(), indexPath.c_str(), &count, &errorLine),
+                testing::Eq(zxerr_encoding_failed));
+    EXPECT_THAT(errorLine, testing::Eq(3u));
+
+    remove(listPath.c_str());
+    remove(indexPath.c_str());
+}
+
+TEST(AddrIndex, AllowList) {
+    // Every address the test vectors send to, To [1] of one transaction left out later
+    vector<string> listed;
+    string withRecipients;
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        vector<uint8_t> buffer;
+        const parser_tx_t tx = readTx(tc.blob, buffer);
+        if (tx.fields[MANTX_FIELD_TO].rlpLen > 0) {
+            listed.push_back(text(tx.fields[MANTX_FIELD_TO]));
+        }
+        for (uint16_t i = 0; i < tx.extraToFieldsItems; i++) {
+            rlp_t items[MANTX_EXTRATOFIELD_COUNT];
+            uint16_t itemCount = 0;
+            ASSERT_THAT(rlp_readList(&tx.extraToListFields[i], items, &itemCount, MANTX_EXTRATOFIELD_COUNT),
+                        testing::Eq(parser_ok));
+            listed.push_back(text(items[0]));
+        }
+        if (tx.extraToFieldsItems > 1 && withRecipients.empty()) {
+            withRecipients = tc.blob;
+        }
+    }
+    ASSERT_FALSE(withRecipients.empty());
+
+    const string listPath = tempPath("mantx_addr");
+    const string indexPath = tempPath("mantx_addr");
+    auto build = [&](const vector<string> &addresses, addrindex_t *index) {
+        string list;
+        for (const auto &a : addresses) {
+            list += a + "\n";
+        }
+        writeFile(listPath, list);
+        uint64_t count = 0;
+        ASSERT_THAT(addrindex_buildFile(listPath.c_str(), indexPath.c_str(), &count, nullptr), testing::Eq(zxerr_ok));
+        ASSERT_THAT(addrindex_open(index, indexPath.c_str()), testing::Eq(zxerr_ok));
+    };
+
+    addrindex_t index;
+    build(listed, &index);
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        vector<uint8_t> buffer;
+        const parser_tx_t tx = readTx(tc.blob, buffer);
+        addrindex_match_t missing;
+        ASSERT_THAT(addrindex_allListedTx(&index, &tx, &missing), testing::Eq(parser_ok)) << tc.name;
+        EXPECT_FALSE(missing.found) << tc.name;
+        EXPECT_THAT(missing.recipient, testing::Eq(ADDRINDEX_MATCH_TO)) << tc.name;
+    }
+
+    // Contract creation: the empty To is not missing, its recipients are still checked
+    vector<uint8_t> creationBuffer;
+    parser_tx_t creation = readTx(withRecipients, creationBuffer);
+    creation.fields[MANTX_FIELD_TO].rlpLen = 0;
+    addrindex_match_t created;
+    ASSERT_THAT(addrindex_allListedTx(&index, &creation, &created), testing::Eq(parser_ok));
+    EXPECT_FALSE(created.found);
+    addrindex_close(&index);
+
+    // Without To [1] of that transaction, it is the one reported
+    vector<uint8_t> buffer;
+    const parser_tx_t tx = readTx(withRecipients, buffer);
+    rlp_t items[MANTX_EXTRATOFIELD_COUNT];
+    uint16_t itemCount = 0;
+    ASSERT_THAT(rlp_readList(&tx.extraToListFields[1], items, &itemCount, MANTX_EXTRATOFIELD_COUNT),
+                testing::Eq(parser_ok));
+    const string dropped = text(items[0]);
+    listed.erase(remove(listed.begin(), listed.end(), dropped), listed.end());
+    build(listed, &index);
+
+    addrindex_match_t missing;
+    ASSERT_THAT(addrindex_allListedTx(&index, &tx, &missing), testing::Eq(parser_ok));
+    EXPECT_TRUE(missing.found);
+    EXPECT_THAT(missing.recipient, testing::Eq(1));
+    ASSERT_THAT(addrindex_allListedTx(&index, &creation, &created), testing::Eq(parser_ok));
+    EXPECT_TRUE(created.found);
+    EXPECT_THAT(created.recipient, testing::Eq(1));
+
+    // The deny list view of the same index still matches the root To
+    addrindex_match_t match;
+    ASSERT_THAT(addrindex_matchTx(&index, &tx, &match), testing::Eq(parser_ok));
+    EXPECT_TRUE(match.found);
+    EXPECT_THAT(match.recipient, testing::Eq(ADDRINDEX_MATCH_TO));
+    addrindex_close(&index);
+
+    remove(listPath.c_str());
+    remove(indexPath.c_str());
+}
@@ -0,0 +1,132 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include "common.h"
+#include "budget.h"
+#include "parser.h"
+
+using namespace std;
+
+namespace {
+    const parser_budget_t unlimited = {UINT32_MAX, UINT32_MAX, UINT32_MAX, 0};
+
+    parser_budget_t spent(const parser_budget_t &budget) {
+        return {UINT32_MAX - budget.items, UINT32_MAX - budget.bytes, UINT32_MAX - budget.divSteps, 0};
+    }
+}
+
+TEST(Budget, ExactBudgetIsEnough) {
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        const auto blob = decodeBlob(tc.blob);
+
+        // Measure the work with an unlimited budget
+        parser_budget_t budget = unlimited;
+        parser_context_t ctx;
+        ASSERT_THAT(parser_parseBudgeted(&ctx, blob.data(), blob.size(), &budget), testing::Eq(parser_ok)) << tc.name;
+        const parser_budget_t parseCost = spent(budget);
+        EXPECT_THAT(parseCost.items, testing::Gt(MANTX_ROOTFIELD_COUNT)) << tc.name;
+        EXPECT_THAT(parseCost.bytes, testing::Eq(0u)) << tc.name;
+
+        ASSERT_THAT(parser_validate(&ctx), testing::Eq(parser_ok)) << tc.name;
+        const parser_budget_t total = spent(budget);
+        EXPECT_THAT(total.bytes, testing::Gt(0u)) << tc.name;
+        EXPECT_THAT(total.divSteps, testing::Gt(0u)) << tc.name;
+
+        // The same amount of work passes, one item less fails
+        budget = total;
+        ASSERT_THAT(parser_parseBudgeted(&ctx, blob.data(), blob.size(), &budget), testing::Eq(parser_ok)) << tc.name;
+        ASSERT_THAT(parser_validate(&ctx), testing::Eq(parser_ok)) << tc.name;
+        EXPECT_FALSE(budget.exhausted);
+
+        budget = parseCost;
+        budget.items--;
+        EXPECT_THAT(parser_parseBudgeted(&ctx, blob.data(), blob.size(), &budget),
+                    testing::Eq(parser_budget_exhausted)) << tc.name;
+        EXPECT_TRUE(budget.exhausted);
+
+        // Unbudgeted parses are not affected by an earlier budget
+        ASSERT_THAT(parser_parse(&ctx, blob.data(), blob.size()), testing::Eq(parser_ok)) << tc.name;
+        ASSERT_THAT(parser_validate(&ctx), testing::Eq(parser_ok)) << tc.name;
+    }
+}
+
+TEST(Budget, RenderingIsCharged) {
+    const auto testcases = GetJsonTestCases("testcases.json");
+    ASSERT_FALSE(testcases.empty());
+    const auto blob = decodeBlob(testcases[0].blob);
+
+    parser_budget_t budget = unlimited;
+    parser_context_t ctx;
+    ASSERT_THAT(parser_parseBudgeted(&ctx, blob.data(), blob.size(), &budget), testing::Eq(parser_ok));
+
+    char key[40];
+    char value[40];
+    uint8_t pageCount = 0;
+
+    // Printing Value takes one division step per digit
+    budget.divSteps = 0;
+    EXPECT_THAT(parser_getItem(&ctx, MANTX_FIELD_VALUE, key, sizeof(key), value, sizeof(value), 0, &pageCount),
+                testing::Eq(parser_budget_exhausted));
+
+    // Once exhausted, everything fails until the caller refills the budget
+    budget = unlimited;
+    budget.exhausted = 1;
+    EXPECT_THAT(parser_getItem(&ctx, MANTX_FIELD_NONCE, key, sizeof(key), value, sizeof(value), 0, &pageCount),
+                testing::Eq(parser_budget_exhausted));
+
+    budget = unlimited;
+    ASSERT_THAT(parser_getItem(&ctx, MANTX_FIELD_TO, key, sizeof(key), value, sizeof(value), 0, &pageCount),
+                testing::Eq(parser_ok));
+    const uint32_t toBytes = spent(budget).bytes;
+    EXPECT_THAT(toBytes, testing::Gt(0u));
+    EXPECT_THAT(toBytes, testing::Le(sizeof(value) - 1));
+
+    budget = unlimited;
+    budget.bytes = toBytes - 1;
+    EXPECT_THAT(parser_getItem(&ctx, MANTX_FIELD_TO, key, sizeof(key), value, sizeof(value), 0, &pageCount),
+                testing::Eq(parser_budget_exhausted));
+
+    // No budget, no limit
+    ctx.budget = nullptr;
+    EXPECT_THAT(parser_getItem(&ctx, MANTX_FIELD_TO, key, sizeof(key), value, sizeof(value), 0, &pageCount),
+                testing::Eq(parser_ok));
+}
+
+TEST(Budget, NestedCallsRestoreTheActiveBudget) {
+    parser_budget_t outer = {2, 0, 0, 0};
+    parser_budget_t inner = {0, 0, 0, 0};
+
+    // Nothing active: always allowed
+    EXPECT_TRUE(budget_spend(budget_items, 1000));
+
+    parser_budget_t *none = budget_enter(&outer);
+    EXPECT_TRUE(none == nullptr);
+    EXPECT_TRUE(budget_spend(budget_items, 1));
+
+    parser_budget_t *previous = budget_enter(&inner);
+    EXPECT_FALSE(budget_spend(budget_items, 1));
+    EXPECT_THAT(budget_leave(previous, parser_unexpected_error), testing::Eq(parser_budget_exhausted));
+
+    EXPECT_TRUE(budget_spend(budget_items, 1));
+    EXPECT_FALSE(budget_spend(budget_items, 1));
+    EXPECT_THAT(budget_leave(none, parser_ok), testing::Eq(parser_budget_exhausted));
+    EXPECT_THAT(outer.items, testing::Eq(0u));
+
+    EXPECT_TRUE(budget_spend(budget_items, 1000));
+    EXPECT_STREQ(parser_getErrorDescription(parser_budget_exhausted), "Work budget exhausted");
+}
@@ -0,0 +1,180 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include <array>
+#include <vector>
+#include <hexutils.h>
+#include "common.h"
+#include "columnar.h"
+#include "crypto_helper.h"
+#include "parser_impl.h"
+#include "rlp.h"
+
+using namespace std;
+
+namespace {
+    struct Columns {
+        explicit Columns(uint32_t rows, uint32_t recipients)
+            : status(rows), nonce(rows), gasPrice(rows), gasLimit(rows), to(rows), value(rows), txType(rows),
+              commitTime(rows), wide(rows), offsets(rows + 1), recipientTo(recipients), recipientAmount(recipients) {
+            cols = {(uint32_t) rows, 0, status.data(), nonce.data(), gasPrice.data(), gasLimit.data(),
+                    reinterpret_cast<uint8_t (*)[ETH_ADDRESS_LEN]>(to.data()), value.data(), txType.data(),
+                    commitTime.data(), wide.data(), offsets.data(),
+                    recipients, 0, reinterpret_cast<uint8_t (*)[ETH_ADDRESS_LEN]>(recipientTo.data()),
+                    recipientAmount.data()};
+            mantx_columns_reset(&cols);
+        }
+
+        vector<uint8_t> status;
+        vector<uint64_t> nonce, gasPrice, gasLimit;
+        vector<array<uint8_t, ETH_ADDRESS_LEN>> to;
+        vector<uint256_t> value;
+        vector<uint8_t> txType;
+        vector<uint64_t> commitTime;
+        vector<uint8_t> wide;
+        vector<uint32_t> offsets;
+        vector<array<uint8_t, ETH_ADDRESS_LEN>> recipientTo;
+        vector<uint256_t> recipientAmount;
+        mantx_columns_t cols{};
+    };
+
+    uint64_t low64(const rlp_t &rlp) {
+        uint256_t value;
+        EXPECT_THAT(rlp_readUInt256(&rlp, &value), testing::Eq(parser_ok));
+        return LOWER(LOWER(value));
+    }
+
+    bool sameValue(const rlp_t &rlp, uint256_t column) {
+        uint256_t value;
+        return rlp_readUInt256(&rlp, &value) == parser_ok && equal256(&value, &column);
+    }
+}
+
+TEST(Columnar, MatchesRead) {
+    vector<vector<uint8_t>> blobs;
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        blobs.push_back(decodeBlob(tc.blob));
+    }
+    // A broken row in the middle keeps every column aligned
+    blobs.insert(blobs.begin() + 1, vector<uint8_t>{0xC1, 0x80});
+
+    vector<const uint8_t *> ptrs;
+    vector<uint16_t> lens;
+    for (const auto &b : blobs) {
+        ptrs.push_back(b.data());
+        lens.push_back((uint16_t) b.size());
+    }
+
+    Columns c((uint32_t) blobs.size(), 1000);
+    ASSERT_THAT(mantx_columns_decode(&c.cols, ptrs.data(), lens.data(), (uint32_t) blobs.size()),
+                testing::Eq(blobs.size()));
+    ASSERT_THAT(c.cols.rows, testing::Eq(blobs.size()));
+
+    EXPECT_THAT(c.status[1], testing::Eq(parser_unexpected_number_items));
+    EXPECT_THAT(c.nonce[1], testing::Eq(0u));
+    EXPECT_THAT(c.offsets[2], testing::Eq(c.offsets[1]));
+
+    for (uint32_t row = 0; row < blobs.size(); row++) {
+        if (row == 1) {
+            continue;
+        }
+        parser_tx_t tx;
+        ASSERT_THAT(readBlob(ptrs[row], lens[row], &tx), testing::Eq(parser_ok));
+
+        ASSERT_THAT(c.status[row], testing::Eq(parser_ok)) << row;
+        EXPECT_THAT(c.nonce[row], testing::Eq(low64(tx.fields[0])));
+        EXPECT_THAT(c.gasPrice[row], testing::Eq(low64(tx.fields[1])));
+        EXPECT_THAT(c.gasLimit[row], testing::Eq(low64(tx.fields[2])));
+        EXPECT_TRUE(sameValue(tx.fields[4], c.value[row]));
+        EXPECT_THAT(c.commitTime[row], testing::Eq(low64(tx.fields[11])));
+        EXPECT_THAT(c.txType[row], testing::Eq(tx.extraTxType));
+        EXPECT_THAT(c.wide[row], testing::Eq(0));
+
+        uint8_t to[ETH_ADDRESS_LEN] = {0};
+        if (tx.fields[3].rlpLen > 0) {
+            ASSERT_THAT(crypto_decodeManAddress(tx.fields[3].ptr, (uint16_t) tx.fields[3].rlpLen, to),
+                        testing::Eq(zxerr_ok));
+        }
+        EXPECT_THAT(memcmp(to, c.to[row].data(), ETH_ADDRESS_LEN), testing::Eq(0));
+
+        ASSERT_THAT(c.offsets[row + 1] - c.offsets[row], testing::Eq(tx.extraToFieldsItems));
+        for (uint16_t i = 0; i < tx.extraToFieldsItems; i++) {
+            rlp_t recipient[MANTX_EXTRATOFIELD_COUNT];
+            uint16_t items = 0;
+            ASSERT_THAT(rlp_readList(&tx.extraToListFields[i], recipient, &items, MANTX_EXTRATOFIELD_COUNT),
+                        testing::Eq(parser_ok));
+            const uint32_t r = c.offsets[row] + i;
+            EXPECT_TRUE(sameValue(recipient[1], c.recipientAmount[r]));
+            ASSERT_THAT(crypto_decodeManAddress(recipient[0].ptr, (uint16_t) recipient[0].rlpLen, to),
+                        testing::Eq(zxerr_ok));
+            EXPECT_THAT(memcmp(to, c.recipientTo[r].data(), ETH_ADDRESS_LEN), testing::Eq(0));
+        }
+    }
+}
+
+TEST(Columnar, StopsWhenFull) {
+    vector<vector<uint8_t>> blobs;
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        blobs.push_back(decodeBlob(tc.blob));
+    }
+    ASSERT_GE(blobs.size(), 2u);
+
+    // Room for a single row
+    Columns rows(1, 1000);
+    EXPECT_THAT(mantx_columns_append(&rows.cols, blobs[0].data(), (uint16_t) blobs[0].size()),
+                testing::Eq(zxerr_ok));
+    EXPECT_THAT(mantx_columns_append(&rows.cols, blobs[1].data(), (uint16_t) blobs[1].size()),
+                testing::Eq(zxerr_buffer_too_small));
+    EXPECT_THAT(rows.cols.rows, testing::Eq(1u));
+
+    // No room for recipients: rows that have some are not added
+    Columns recipients((uint32_t) blobs.size(), 0);
+    for (const auto &b : blobs) {
+        parser_tx_t tx;
+        ASSERT_THAT(readBlob(b, &tx), testing::Eq(parser_ok));
+
+        const uint32_t before = recipients.cols.rows;
+        const auto err = mantx_columns_append(&recipients.cols, b.data(), (uint16_t) b.size());
+        if (tx.extraToFieldsItems > 0) {
+            EXPECT_THAT(err, testing::Eq(zxerr_buffer_too_small));
+            EXPECT_THAT(recipients.cols.rows, testing::Eq(before));
+        } else {
+            EXPECT_THAT(err, testing::Eq(zxerr_ok));
+            EXPECT_THAT(recipients.cols.rows, testing::Eq(before + 1));
+        }
+    }
+}
+
+TEST(Columnar, WideValuesSaturate) {
+    // Example1 with a 72-bit nonce and a 72-bit commit time, both accepted by the parser
+    vector<uint8_t> blob(200);
+    blob.resize(parseHexString(blob.data(), blob.size(),
+                               "f84e89010000000000000008850430e23400825208a14d414e2e32556f7a3867386a61754d61326d74"
+                               "6e7778727363686a3271504a72458398968080038080808089010000000000000000c4c38080c0"));
+    parser_tx_t tx;
+    ASSERT_THAT(readBlob(blob, &tx), testing::Eq(parser_ok));
+
+    Columns c(1, 0);
+    ASSERT_THAT(mantx_columns_append(&c.cols, blob.data(), (uint16_t) blob.size()), testing::Eq(zxerr_ok));
+    EXPECT_THAT(c.status[0], testing::Eq(parser_ok));
+    EXPECT_THAT(c.wide[0], testing::Eq(COLUMNAR_WIDE_NONCE | COLUMNAR_WIDE_COMMITTIME));
+    EXPECT_THAT(c.nonce[0], testing::Eq(UINT64_MAX));
+    EXPECT_THAT(c.commitTime[0], testing::Eq(UINT64_MAX));
+    EXPECT_THAT(c.gasPrice[0], testing::Eq(low64(tx.fields[MANTX_FIELD_GASPRICE])));
+    EXPECT_THAT(c.gasLimit[0], testing::Eq(low64(tx.fields[MANTX_FIELD_GASLIMIT])));
+}
@@ -26,6 +26,7 @@
 #include <json/json.h>
 #include <app_mode.h>
 #include <hexutils.h>
+#include <unistd.h>
 #include "parser.h"
 
 std::vector<std::string> dumpUI(parser_context_t *ctx,
@@ -164,3 +165,33 @@ void check_testcase(const testcase_t &tc, bool expert_mode) {
     }
 #endif
 }
+
+std::vector<uint8_t> decodeBlob(const std::string &hex) {
+    std::vector<uint8_t> blob(hex.size() / 2);
+    blob.resize(parseHexString(blob.data(), (uint16_t) blob.size(), hex.c_str()));
+    return blob;
+}
+
+parser_error_t readBlob(const std::vector<uint8_t> &blob, parser_tx_t *tx) {
+    return readBlob(blob.data(), (uint16_t) blob.size(), tx);
+}
+
+parser_error_t readBlob(const uint8_t *blob, uint16_t blobLen, parser_tx_t *tx) {
+    memset(tx, 0, sizeof(*tx));
+    parser_context_t ctx = {.buffer = blob, .bufferLen = blobLen, .offset = 0, .tx_obj = tx, .budget = nullptr};
+    return _read(&ctx, tx);
+}
+
+bool sameSpan(const rlp_t &a, const rlp_t &b) {
+    return a.kind == b.kind && a.ptr == b.ptr && a.rlpLen == b.rlpLen;
+}
+
+std::string tempPath(const std::string &prefix) {
+    std::string path = "/tmp/" + prefix + "XXXXXX";
+    const int fd = mkstemp(&path[0]);
+    EXPECT_GE(fd, 0) << path;
+    if (fd >= 0) {
+        close(fd);
+    }
+    return path;
+}
@@ -15,6 +15,7 @@
 ********************************************************************************/
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include "parser_common.h"
@@ -49,3 +50,16 @@ std::vector<std::string> dumpUI(parser_context_t *ctx, uint16_t maxKeyLen, uint1
 std::vector<testcase_t> GetJsonTestCases(const std::string &jsonFile);
 
 void check_testcase(const testcase_t &tc, bool expert_mode);
+
+/// Bytes of a hex blob, as stored in the json test vectors
+std::vector<uint8_t> decodeBlob(const std::string &hex);
+
+/// Clears tx and reads the blob into it with _read, without a budget
+parser_error_t readBlob(const std::vector<uint8_t> &blob, parser_tx_t *tx);
+parser_error_t readBlob(const uint8_t *blob, uint16_t blobLen, parser_tx_t *tx);
+
+/// Same kind and same bytes of the same buffer
+bool sameSpan(const rlp_t &a, const rlp_t &b);
+
+/// Creates an empty file named /tmp/<prefix>XXXXXX and returns its path
+std::string tempPath(const std::string &prefix);
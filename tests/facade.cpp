@@ -0,0 +1,129 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include <string>
+#include <vector>
+#include <fmt/core.h>
+#include "common.h"
+#include "mantx.hpp"
+
+using namespace std;
+
+namespace {
+    string str(const mantx::text_view &v) {
+        return string(v.data(), v.size());
+    }
+}
+
+TEST(Facade, PagesMatchDumpUI) {
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        const auto blob = decodeBlob(tc.blob);
+
+        mantx::transaction tx;
+        ASSERT_THAT(tx.parse(blob.data(), blob.size()), testing::Eq(parser_ok)) << tc.name;
+        ASSERT_THAT(tx.validate(), testing::Eq(parser_ok)) << tc.name;
+
+        // Same rendering as dumpUI, which goes through the global context
+        parser_context_t ctx;
+        ASSERT_THAT(parser_parse(&ctx, blob.data(), blob.size()), testing::Eq(parser_ok));
+        const auto expected = dumpUI(&ctx, 40, 40);
+
+        vector<string> actual;
+        for (const auto &page : tx.pages<40, 40>()) {
+            string line = fmt::format("{} | {}", page.index, str(page.key));
+            if (page.pageCount > 1) {
+                line += fmt::format("[{}/{}]", page.page + 1, page.pageCount);
+            }
+            line += " : ";
+            line += page.error == parser_ok ? str(page.value) : string(parser_getErrorDescription(page.error));
+            if (line.back() == ' ') {
+                line.pop_back();
+            }
+            actual.push_back(line);
+        }
+        EXPECT_THAT(actual, testing::ElementsAreArray(expected)) << tc.name;
+    }
+}
+
+TEST(Facade, CopiedPagesOwnTheirText) {
+    const auto tc = GetJsonTestCases("testcases.json").front();
+    const auto blob = decodeBlob(tc.blob);
+
+    mantx::transaction tx;
+    ASSERT_THAT(tx.parse(blob.data(), blob.size()), testing::Eq(parser_ok));
+    auto pages = tx.pages<40, 40>();
+
+    auto it = pages.begin();
+    const auto first = it;
+    auto assigned = pages.end();
+    assigned = it;
+    const string key = str(it->key);
+    const string value = str(it->value);
+
+    // Moving the source on must not change what the copies show
+    ++it;
+    ASSERT_TRUE(it != first);
+    EXPECT_TRUE(first->key.data() != it->key.data());
+    EXPECT_THAT(str(first->key), testing::Eq(key));
+    EXPECT_THAT(str(first->value), testing::Eq(value));
+    EXPECT_THAT(str(assigned->key), testing::Eq(key));
+    EXPECT_THAT(str(assigned->value), testing::Eq(value));
+    EXPECT_TRUE(assigned == first);
+}
+
+TEST(Facade, Views) {
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        const auto blob = decodeBlob(tc.blob);
+
+        mantx::transaction tx;
+        ASSERT_THAT(tx.parse(blob.data(), blob.size()), testing::Eq(parser_ok));
+        const parser_tx_t &raw = tx.raw();
+
+        // Views point into the blob
+        EXPECT_TRUE(tx.to().data() == reinterpret_cast<const char *>(raw.fields[MANTX_FIELD_TO].ptr));
+        EXPECT_THAT(tx.to().size(), testing::Eq(raw.fields[MANTX_FIELD_TO].rlpLen));
+        EXPECT_TRUE(tx.data().data() == raw.fields[MANTX_FIELD_DATA].ptr);
+        EXPECT_GE(tx.data().data(), blob.data());
+        EXPECT_LE(tx.data().end(), blob.data() + blob.size());
+
+        char value[100];
+        ASSERT_THAT(tx.value().format(value, sizeof(value)), testing::Eq(parser_ok));
+        uint256_t expected;
+        ASSERT_THAT(rlp_readUInt256(&raw.fields[MANTX_FIELD_VALUE], &expected), testing::Eq(parser_ok));
+        char expectedStr[100];
+        ASSERT_TRUE(tostring256(&expected, 10, expectedStr, sizeof(expectedStr)));
+        EXPECT_THAT(string(value), testing::Eq(expectedStr));
+
+        size_t count = 0;
+        for (const auto &r : tx.recipients()) {
+            EXPECT_THAT(r.to.size(), testing::Gt(0u));
+            EXPECT_THAT(r.value.format(value, sizeof(value)), testing::Eq(parser_ok));
+            count++;
+        }
+        EXPECT_THAT(count, testing::Eq(raw.extraToFieldsItems));
+        EXPECT_THAT(tx.recipients().size(), testing::Eq(count));
+    }
+
+    // Nothing to show before a successful parse
+    mantx::transaction empty;
+    EXPECT_THAT(empty.validate(), testing::Eq(parser_no_data));
+    EXPECT_TRUE(empty.pages().begin() == empty.pages().end());
+    const uint8_t broken[] = {0xC1, 0x80};
+    EXPECT_THAT(empty.parse(broken, sizeof(broken)), testing::Eq(parser_unexpected_number_items));
+    EXPECT_TRUE(empty.pages().begin() == empty.pages().end());
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "common.h"
+#include "metrics.h"
+#include "parser.h"
+
+using namespace std;
+
+namespace {
+    uint64_t sum(const uint64_t *counters, size_t len) {
+        uint64_t total = 0;
+        for (size_t i = 0; i < len; i++) {
+            total += counters[i];
+        }
+        return total;
+    }
+
+    // Counters only grow, tests look at what changed
+    parser_metrics_t delta(const parser_metrics_t &before, const parser_metrics_t &after) {
+        parser_metrics_t d;
+        const auto *b = reinterpret_cast<const uint64_t *>(&before);
+        const auto *a = reinterpret_cast<const uint64_t *>(&after);
+        auto *out = reinterpret_cast<uint64_t *>(&d);
+        for (size_t i = 0; i < sizeof(d) / sizeof(uint64_t); i++) {
+            out[i] = a[i] - b[i];
+        }
+        return d;
+    }
+}
+
+TEST(Metrics, ThreadsAreMergedAfterExit) {
+    parser_metrics_t before;
+    metrics_snapshot(&before);
+
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([]() {
+            for (int i = 0; i < 100; i++) {
+                metrics_record(metrics_op_getItem, metrics_now(), parser_ok);
+                metrics_recordTx(10, MANTX_TXTYPE_BROADCAST, 2);
+            }
+            metrics_record(metrics_op_parse, metrics_now(), parser_unexpected_buffer_end);
+        });
+    }
+    for (auto &th : threads) {
+        th.join();
+    }
+    // And one that is still alive
+    metrics_record(metrics_op_validate, metrics_now(), parser_ok);
+
+    parser_metrics_t after;
+    metrics_snapshot(&after);
+    const parser_metrics_t d = delta(before, after);
+
+    EXPECT_THAT(d.txs, testing::Eq(400u));
+    EXPECT_THAT(d.bytes, testing::Eq(4000u));
+    EXPECT_THAT(d.recipients, testing::Eq(800u));
+    EXPECT_THAT(d.txTypes[MANTX_TXTYPE_BROADCAST], testing::Eq(400u));
+    EXPECT_THAT(d.results[metrics_op_getItem][parser_ok], testing::Eq(400u));
+    EXPECT_THAT(d.results[metrics_op_parse][parser_unexpected_buffer_end], testing::Eq(4u));
+    EXPECT_THAT(d.results[metrics_op_validate][parser_ok], testing::Eq(1u));
+    EXPECT_THAT(sum(d.latency[metrics_op_getItem], METRICS_LATENCY_BUCKETS), testing::Eq(400u));
+
+    parser_metrics_t merged;
+    memset(&merged, 0, sizeof(merged));
+    metrics_merge(&merged, &d);
+    metrics_merge(&merged, &d);
+    EXPECT_THAT(merged.txs, testing::Eq(800u));
+}
+
+#ifdef PARSER_METRICS
+TEST(Metrics, ParserIsInstrumented) {
+    const auto testcases = GetJsonTestCases("testcases.json");
+    parser_metrics_t before;
+    metrics_snapshot(&before);
+
+    uint64_t bytes = 0;
+    for (const auto &tc : testcases) {
+        const auto blob = decodeBlob(tc.blob);
+        parser_context_t ctx;
+        ASSERT_THAT(parser_parse(&ctx, blob.data(), blob.size()), testing::Eq(parser_ok));
+        ASSERT_THAT(parser_validate(&ctx), testing::Eq(parser_ok));
+        bytes += blob.size();
+    }
+    parser_context_t ctx;
+    EXPECT_THAT(parser_parse(&ctx, nullptr, 0), testing::Eq(parser_init_context_empty));
+
+    parser_metrics_t after;
+    metrics_snapshot(&after);
+    const parser_metrics_t d = delta(before, after);
+    EXPECT_THAT(d.txs, testing::Eq(testcases.size()));
+    EXPECT_THAT(d.bytes, testing::Eq(bytes));
+    EXPECT_THAT(d.results[metrics_op_parse][parser_ok], testing::Eq(testcases.size()));
+    EXPECT_THAT(d.results[metrics_op_parse][parser_init_context_empty], testing::Eq(1u));
+    EXPECT_THAT(d.results[metrics_op_validate][parser_ok], testing::Eq(testcases.size()));
+    // validate renders every item without counting them as getItem calls
+    EXPECT_THAT(d.results[metrics_op_getItem][parser_ok], testing::Eq(0u));
+    EXPECT_THAT(sum(d.txTypes, METRICS_TX_TYPES), testing::Eq(testcases.size()));
+}
+#endif
@@ -0,0 +1,229 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include <vector>
+#include <string>
+#include <fmt/core.h>
+#include <hexutils.h>
+#include "parser.h"
+
+using namespace std;
+
+static const char *TX_NORMAL =
+        "f8478710000000000008850430e23400825208a14d414e2e32556f7a3867386a61754d61326d746e7778727363686a3271504a72458398"
+        "9680800380808080845c3d93c9c4c38080c0";
+
+static const char *TX_NORMAL_EXTRA_TO =
+        "f8c0871000000000000f850430e2340083033450a14d414e2e32556f7a3867386a61754d61326d746e7778727363686a3271504a724583"
+        "989680800380808080845c3d93c9f87bf8798080f875e6a04d414e2e6a4c5446686f434a43474368706964553269433151357a436d5646"
+        "4c8398968080e6a04d414e2e66344657484562576b583873536438796a5a6a5948655a576e6164788398968080e6a04d414e2e67514141"
+        "4855655442787667627a6638744667557461764463654a508398968080";
+
+static const char *TX_AUTHORIZE =
+        "f8b5871000000000000b850430e2340083033450a04d414e2e576b62756a7478683759426e6b475638485a767950514b33634150798" \
+        "0b8705b7b22456e7472757374416464726573223a224d414e2e3661706346595162595a68774c5a7a33626234546a666b67346d794a22" \
+        "2c224973456e7472757374476173223a747275652c22456e73747275737453657454797065223a322c22456e7472757374436f756e7422" \
+        "3a32307d5d0380808080845c3d93c9c4c30580c0";
+
+static const char *RECIPIENTS[] = {
+        "e6a04d414e2e6a4c5446686f434a43474368706964553269433151357a436d56464c8398968080",
+        "e6a04d414e2e66344657484562576b583873536438796a5a6a5948655a576e6164788398968080",
+        "e6a04d414e2e675141414855655442787667627a6638744667557461764463654a508398968080",
+};
+
+static string rlpListHex(const string &items) {
+    const size_t len = items.size() / 2;
+    if (len < 56) {
+        return fmt::format("{:02x}", 0xc0 + len) + items;
+    }
+    const string lenHex = len <= 0xFF ? fmt::format("{:02x}", len) : fmt::format("{:04x}", len);
+    return fmt::format("{:02x}", 0xf7 + lenHex.size() / 2) + lenHex + items;
+}
+
+// Plain transfer like TX_NORMAL, single byte fields are given as their encoding
+struct transfer_t {
+    uint8_t recipients = 0;
+    string chainId = "03";
+    string enterType = "80";
+    string isEntrustTx = "80";
+    string lockHeight = "80";
+};
+
+static string transferHex(const transfer_t &t) {
+    string extraTo;
+    for (uint8_t i = 0; i < t.recipients; i++) {
+        extraTo += RECIPIENTS[i % 3];
+    }
+    const string extra = rlpListHex(rlpListHex("80" + t.lockHeight + rlpListHex(extraTo)));
+    return rlpListHex("8710000000000008850430e23400825208a14d414e2e32556f7a3867386a61754d61326d746e7778727363686a3271504a7245"
+                      "83989680" "80" + t.chainId + "8080" + t.enterType + t.isEntrustTx + "845c3d93c9" + extra);
+}
+
+// Packs transactions as [len: u16 BE][tx bytes]...
+static vector<uint8_t> packBatch(const vector<string> &txs) {
+    vector<uint8_t> out;
+    for (const auto &tx : txs) {
+        uint8_t buffer[1000] = {0};
+        const size_t len = parseHexString(buffer, sizeof(buffer), tx.c_str());
+        out.push_back((len >> 8) & 0xFF);
+        out.push_back(len & 0xFF);
+        out.insert(out.end(), buffer, buffer + len);
+    }
+    return out;
+}
+
+static vector<string> dumpBatchUI(const parser_batch_t *batch) {
+    vector<string> answer;
+    uint8_t numItems = 0;
+    if (parser_batch_getNumItems(batch, &numItems) != parser_ok) {
+        return answer;
+    }
+
+    for (uint8_t idx = 0; idx < numItems; idx++) {
+        char key[40];
+        char value[40];
+        uint8_t pageCount = 1;
+        const parser_error_t err = parser_batch_getItem(batch, idx, key, sizeof(key), value, sizeof(value), 0, &pageCount);
+        answer.push_back(err == parser_ok ? fmt::format("{} | {} : {}", idx, key, value)
+                                          : fmt::format("{} | {}", idx, parser_getErrorDescription(err)));
+    }
+    return answer;
+}
+
+TEST(Batch, ConsolidatedReview) {
+    const auto packed = packBatch({TX_NORMAL, TX_NORMAL_EXTRA_TO});
+
+    parser_batch_t batch;
+    ASSERT_EQ(parser_batch_parse(&batch, packed.data(), packed.size()), parser_ok);
+    EXPECT_EQ(batch.count, 2);
+
+    const vector<string> expected {
+        "0 | Batch : 2 transactions",
+        "1 | ChainID : 3",
+        "2 | Total Value : 50000000",
+        "3 | Tx 1 Nonce : 4503599627370504",
+        "4 | Tx 1 To : MAN.2Uoz8g8jauMa2mtnwxrschj2qPJrE",
+        "5 | Tx 1 Value : 10000000",
+        "6 | Tx 1 Max Fee : 378000000000000",
+        "7 | Tx 1 CommitTime : 15Jan2019 08:03:21UTC",
+        "8 | Tx 2 Nonce : 4503599627370511",
+        "9 | Tx 2 To : MAN.2Uoz8g8jauMa2mtnwxrschj2qPJrE",
+        "10 | Tx 2 Value : 10000000",
+        "11 | Tx 2 Max Fee : 3780000000000000",
+        "12 | Tx 2 CommitTime : 15Jan2019 08:03:21UTC",
+        "13 | Tx 2 To [0] : MAN.jLTFhoCJCGChpidU2iC1Q5zCmVFL",
+        "14 | Tx 2 Amount [0] : 10000000",
+        "15 | Tx 2 To [1] : MAN.f4FWHEbWkX8sSd8yjZjYHeZWnadx",
+        "16 | Tx 2 Amount [1] : 10000000",
+        "17 | Tx 2 To [2] : MAN.gQAAHUeTBxvgbzf8tFgUtavDceJP",
+        "18 | Tx 2 Amount [2] : 10000000",
+    };
+    EXPECT_THAT(dumpBatchUI(&batch), testing::ElementsAreArray(expected));
+
+    const uint8_t *tx = nullptr;
+    uint16_t txLen = 0;
+    ASSERT_EQ(parser_batch_getTx(&batch, 1, &tx, &txLen), parser_ok);
+    EXPECT_EQ(txLen, 194);
+    EXPECT_EQ(tx, packed.data() + 2 + 73 + 2);
+    EXPECT_EQ(parser_batch_getTx(&batch, 2, &tx, &txLen), parser_display_idx_out_of_range);
+}
+
+TEST(Batch, RejectsNonTransfers) {
+    const auto packed = packBatch({TX_NORMAL, TX_AUTHORIZE});
+
+    parser_batch_t batch;
+    EXPECT_EQ(parser_batch_parse(&batch, packed.data(), packed.size()), parser_unexpected_type);
+}
+
+TEST(Batch, RejectsHiddenFields) {
+    parser_batch_t batch;
+    const transfer_t plain;
+    const auto accepted = packBatch({transferHex(plain), TX_NORMAL});
+    ASSERT_EQ(parser_batch_parse(&batch, accepted.data(), accepted.size()), parser_ok);
+
+    transfer_t entrusted;
+    entrusted.isEntrustTx = "01";
+    transfer_t entered;
+    entered.enterType = "01";
+    transfer_t locked;
+    locked.lockHeight = "820400";
+    transfer_t otherChain;
+    otherChain.chainId = "04";
+
+    for (const auto &t : {entrusted, entered, locked, otherChain}) {
+        // Each one is a valid transaction on its own
+        const auto single = packBatch({transferHex(t)});
+        const parser_error_t err = parser_batch_parse(&batch, single.data(), single.size());
+        if (t.chainId == plain.chainId) {
+            EXPECT_EQ(err, parser_unexpected_value);
+        } else {
+            EXPECT_EQ(err, parser_ok);
+        }
+
+        const auto packed = packBatch({TX_NORMAL, transferHex(t)});
+        EXPECT_EQ(parser_batch_parse(&batch, packed.data(), packed.size()), parser_unexpected_value);
+    }
+}
+
+TEST(Batch, ItemLimit) {
+    // 3 + 8 * 5 + 2 * 42 = 127 items, the most an int8_t display index reaches
+    transfer_t full;
+    full.recipients = MANTX_EXTRALISTFIELD_COUNT;
+    transfer_t two;
+    two.recipients = 2;
+    vector<string> txs(MANTX_BATCH_MAX, transferHex(transfer_t()));
+    for (uint8_t i = 0; i < 4; i++) {
+        txs[i] = transferHex(full);
+    }
+    txs[4] = transferHex(two);
+    auto packed = packBatch(txs);
+
+    parser_batch_t batch;
+    ASSERT_EQ(parser_batch_parse(&batch, packed.data(), packed.size()), parser_ok);
+    uint8_t numItems = 0;
+    ASSERT_EQ(parser_batch_getNumItems(&batch, &numItems), parser_ok);
+    EXPECT_EQ(numItems, MANTX_BATCH_MAX_ITEMS);
+
+    const auto ui = dumpBatchUI(&batch);
+    ASSERT_EQ(ui.size(), MANTX_BATCH_MAX_ITEMS);
+    EXPECT_EQ(ui.back(), "126 | Tx 8 CommitTime : 15Jan2019 08:03:21UTC");
+
+    // One more recipient goes past the limit
+    transfer_t one;
+    one.recipients = 1;
+    txs.back() = transferHex(one);
+    packed = packBatch(txs);
+    EXPECT_EQ(parser_batch_parse(&batch, packed.data(), packed.size()), parser_value_out_of_range);
+}
+
+TEST(Batch, RejectsMalformedPacking) {
+    auto packed = packBatch({TX_NORMAL, TX_NORMAL});
+    parser_batch_t batch;
+
+    // Truncated last transaction
+    EXPECT_EQ(parser_batch_parse(&batch, packed.data(), packed.size() - 1), parser_unexpected_buffer_end);
+
+    // Dangling length prefix
+    packed.push_back(0x00);
+    EXPECT_EQ(parser_batch_parse(&batch, packed.data(), packed.size()), parser_unexpected_buffer_end);
+
+    // Too many transactions
+    vector<string> many(MANTX_BATCH_MAX + 1, TX_NORMAL);
+    const auto tooMany = packBatch(many);
+    EXPECT_EQ(parser_batch_parse(&batch, tooMany.data(), tooMany.size()), parser_value_out_of_range);
+}
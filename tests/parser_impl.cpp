@@ -19,7 +19,11 @@
 #include "gmock/gmock.h"
 
 #include <vector>
+#include <array>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <random>
 #include <hexutils.h>
 #include "parser_txdef.h"
 #include "parser.h"
@@ -152,3 +156,212 @@ TEST(Address, MatrixAIAddressTests) {
                 EXPECT_THAT(actualAddress[address_len - 1], testing::Eq(crcByte));
         }
 }
+
+TEST(Address, EthAddressBase58MatchesGeneric) {
+    std::mt19937 rng(1234);
+    std::vector<std::array<uint8_t, ETH_ADDRESS_LEN>> inputs;
+
+    for (int i = 0; i < 2000; i++) {
+        std::array<uint8_t, ETH_ADDRESS_LEN> in{};
+        for (auto &b : in) b = (uint8_t) rng();
+        // Exercise leading zero bytes and all-zero limbs
+        const int zeros = i % (ETH_ADDRESS_LEN + 1);
+        std::fill(in.begin(), in.begin() + zeros, 0);
+        inputs.push_back(in);
+    }
+    std::array<uint8_t, ETH_ADDRESS_LEN> ones{};
+    ones.fill(0xFF);
+    inputs.push_back(ones);
+
+    for (const auto &in : inputs) {
+        uint8_t expected[100] = {0};
+        size_t expectedLen = sizeof(expected);
+        ASSERT_THAT(encode_base58(in.data(), in.size(), expected, &expectedLen), testing::Eq(0));
+
+        uint8_t actual[ETH_ADDRESS_B58_MAXLEN] = {0};
+        const uint8_t actualLen = crypto_encodeEthAddress(actual, sizeof(actual), in.data());
+
+        ASSERT_THAT(std::string(actual, actual + actualLen),
+                    testing::Eq(std::string(expected, expected + expectedLen)));
+    }
+
+    uint8_t small[ETH_ADDRESS_B58_MAXLEN - 1];
+    EXPECT_THAT(crypto_encodeEthAddress(small, sizeof(small), inputs[0].data()), testing::Eq(0));
+}
+
+// Timing only, not run by default: --gtest_also_run_disabled_tests --gtest_filter=Address.DISABLED_*
+TEST(Address, DISABLED_EthAddressBase58Benchmark) {
+    std::mt19937 rng(1234);
+    std::vector<std::array<uint8_t, ETH_ADDRESS_LEN>> inputs(2000);
+    for (auto &in : inputs) {
+        for (auto &b : in) b = (uint8_t) rng();
+    }
+
+    constexpr int reps = 200;
+    uint8_t out[100];
+    size_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < reps; rep++) {
+        for (const auto &in : inputs) {
+            size_t outLen = sizeof(out);
+            encode_base58(in.data(), in.size(), out, &outLen);
+            sink += outLen;
+        }
+    }
+    const double generic = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < reps; rep++) {
+        for (const auto &in : inputs) {
+            sink += crypto_encodeEthAddress(out, sizeof(out), in.data());
+        }
+    }
+    const double specialized = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    const double calls = (double) reps * inputs.size();
+    std::cout << "base58 generic: " << generic / calls << " ns/address, 160-bit: "
+              << specialized / calls << " ns/address, speedup " << generic / specialized << "x" << std::endl;
+    EXPECT_THAT(sink, testing::Gt(0u));
+}
+
+TEST(crypto, keccakStreamMatchesOneShot) {
+    std::mt19937 rng(99);
+    std::vector<uint8_t> data(1000);
+    for (auto &b : data) b = (uint8_t) rng();
+
+    for (unsigned int len : {0u, 1u, 7u, 8u, 64u, 135u, 136u, 137u, 272u, 1000u}) {
+        uint8_t expected[32];
+        keccak_hash(data.data(), len, expected, sizeof(expected));
+
+        // Feed the same input in random segments
+        for (int attempt = 0; attempt < 20; attempt++) {
+            keccak_ctx_t ctx;
+            ASSERT_THAT(keccak_init(&ctx), testing::Eq(zxerr_ok));
+            unsigned int offset = 0;
+            while (offset < len) {
+                const unsigned int segment = std::min<unsigned int>(len - offset, rng() % 150);
+                ASSERT_THAT(keccak_update(&ctx, data.data() + offset, segment), testing::Eq(zxerr_ok));
+                offset += segment;
+            }
+            uint8_t actual[32];
+            ASSERT_THAT(keccak_final(&ctx, actual, sizeof(actual)), testing::Eq(zxerr_ok));
+            EXPECT_TRUE(memcmp(expected, actual, sizeof(actual)) == 0) << "len " << len;
+        }
+    }
+
+    // Output longer than the rate needs an extra permutation
+    uint8_t expectedLong[200];
+    keccak_hash(data.data(), 50, expectedLong, sizeof(expectedLong));
+    keccak_ctx_t ctx;
+    keccak_init(&ctx);
+    keccak_update(&ctx, data.data(), 50);
+    uint8_t actualLong[200];
+    keccak_final(&ctx, actualLong, sizeof(actualLong));
+    EXPECT_TRUE(memcmp(expectedLong, actualLong, sizeof(actualLong)) == 0);
+}
+
+TEST(crypto, keccakBatchMatchesScalar) {
+    std::mt19937 rng(42);
+
+    // Lengths around the rate (136 bytes) and the 64-byte pubkey case
+    for (unsigned int len : {0u, 1u, 64u, 135u, 136u, 137u, 300u}) {
+        for (unsigned int count : {1u, 3u, 4u, 7u, 8u, 13u}) {
+            std::vector<std::vector<uint8_t>> msgs(count, std::vector<uint8_t>(len));
+            std::vector<std::array<uint8_t, 32>> hashes(count);
+            std::vector<const unsigned char *> in;
+            std::vector<unsigned char *> out;
+            for (unsigned int i = 0; i < count; i++) {
+                for (auto &b : msgs[i]) b = (uint8_t) rng();
+                in.push_back(msgs[i].data());
+                out.push_back(hashes[i].data());
+            }
+
+            ASSERT_THAT(keccak_hash_batch(in.data(), len, out.data(), 32, count), testing::Eq(zxerr_ok));
+            for (unsigned int i = 0; i < count; i++) {
+                uint8_t expected[32];
+                keccak_hash(msgs[i].data(), len, expected, sizeof(expected));
+                EXPECT_TRUE(memcmp(expected, hashes[i].data(), 32) == 0) << "len " << len << " lane " << i;
+            }
+        }
+    }
+}
+
+TEST(Address, EncodePubkeysBatch) {
+    std::mt19937 rng(7);
+    const uint16_t count = 21;
+    std::vector<std::array<uint8_t, SECP256K1_PUBKEY_LEN - 1>> pubkeys(count);
+    for (auto &pk : pubkeys) {
+        for (auto &b : pk) b = (uint8_t) rng();
+    }
+
+    std::vector<std::array<uint8_t, ADDRESS_LEN>> addresses(count);
+    std::vector<uint8_t> addressLens(count);
+    ASSERT_THAT(crypto_encodePubkeys(reinterpret_cast<uint8_t (*)[ADDRESS_LEN]>(addresses.data()),
+                                     addressLens.data(),
+                                     reinterpret_cast<const uint8_t (*)[SECP256K1_PUBKEY_LEN - 1]>(pubkeys.data()),
+                                     count),
+                testing::Eq(zxerr_ok));
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t expected[ADDRESS_LEN] = {0};
+        const uint8_t expectedLen = crypto_encodePubkey(expected, sizeof(expected), pubkeys[i].data());
+        ASSERT_THAT(addressLens[i], testing::Eq(expectedLen));
+        EXPECT_THAT(std::string(addresses[i].begin(), addresses[i].begin() + addressLens[i]),
+                    testing::Eq(std::string(expected, expected + expectedLen)));
+    }
+}
+
+TEST(Address, DecodeManAddress) {
+    std::mt19937 rng(5);
+    for (int i = 0; i < 500; i++) {
+        uint8_t pubkey[SECP256K1_PUBKEY_LEN - 1];
+        for (auto &b : pubkey) b = (uint8_t) rng();
+
+        uint8_t address[ADDRESS_LEN] = {0};
+        const uint8_t addressLen = crypto_encodePubkey(address, sizeof(address), pubkey);
+        ASSERT_GT(addressLen, 0);
+
+        uint8_t hash[KECCAK_HASH_SIZE];
+        keccak_hash(pubkey, sizeof(pubkey), hash, sizeof(hash));
+
+        uint8_t decoded[ETH_ADDRESS_LEN] = {0};
+        ASSERT_THAT(crypto_decodeManAddress(address, addressLen, decoded), testing::Eq(zxerr_ok));
+        EXPECT_TRUE(memcmp(decoded, hash + 12, ETH_ADDRESS_LEN) == 0);
+    }
+
+    const auto check = [](const std::string &address) {
+        return crypto_decodeManAddress((const uint8_t *) address.data(), address.size(), nullptr);
+    };
+    EXPECT_THAT(check("MAN.2Uoz8g8jauMa2mtnwxrschj2qPJrE"), testing::Eq(zxerr_ok));
+    // Wrong checksum
+    EXPECT_THAT(check("MAN.2Uoz8g8jauMa2mtnwxrschj2qPJrF"), testing::Eq(zxerr_encoding_failed));
+    // Wrong prefix
+    EXPECT_THAT(check("MAX.2Uoz8g8jauMa2mtnwxrschj2qPJrE"), testing::Eq(zxerr_encoding_failed));
+    // Character outside the alphabet
+    EXPECT_THAT(check("MAN.0Uoz8g8jauMa2mtnwxrschj2qPJrE"), testing::Eq(zxerr_encoding_failed));
+    // Empty and truncated
+    EXPECT_THAT(check(""), testing::Eq(zxerr_encoding_failed));
+    EXPECT_THAT(check("MAN."), testing::Eq(zxerr_encoding_failed));
+
+    // Checksum is valid but the value does not fit in 160 bits
+    std::string tooBig = "MAN.zzzzzzzzzzzzzzzzzzzzzzzzzzzz";
+    tooBig += encode_base58_clip(crc8((const uint8_t *) tooBig.data(), tooBig.size()));
+    EXPECT_THAT(check(tooBig), testing::Eq(zxerr_encoding_failed));
+
+    // Checksum is valid but a leading '1' does not match a zero byte
+    std::string nonCanonical = "MAN.1Wkbujtxh7YBnkGV8HZvyPQK3cAP";
+    nonCanonical += encode_base58_clip(crc8((const uint8_t *) nonCanonical.data(), nonCanonical.size()));
+    EXPECT_THAT(check(nonCanonical), testing::Eq(zxerr_encoding_failed));
+}
+
+TEST(Address, ParserRejectsInvalidRecipient) {
+    // Example1 with the checksum character of To changed from 'E' to 'F'
+    const std::string blob = "f8478710000000000008850430e23400825208a14d414e2e32556f7a3867386a61754d61326d746e7778727363686a3271504a724683989680800380808080845c3d93c9c4c38080c0";
+    uint8_t buffer[200];
+    const auto bufferLen = parseHexString(buffer, sizeof(buffer), blob.c_str());
+
+    parser_context_t ctx;
+    EXPECT_THAT(parser_parse(&ctx, buffer, bufferLen), testing::Eq(parser_invalid_address));
+    EXPECT_STREQ(parser_getErrorDescription(parser_invalid_address), "Invalid address");
+}
@@ -0,0 +1,149 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include <string>
+#include "common.h"
+#include "parser_impl.h"
+#include "policy.h"
+#include "rlp.h"
+
+using namespace std;
+
+namespace {
+    policy_program_t compile(const string &rules) {
+        policy_program_t program;
+        uint8_t errorRule = 0;
+        EXPECT_THAT(policy_compile(rules.c_str(), rules.size(), &program, &errorRule), testing::Eq(parser_ok))
+            << rules << " rule " << (int) errorRule;
+        return program;
+    }
+
+    string decimal(const rlp_t &rlp) {
+        uint256_t value;
+        char out[80];
+        EXPECT_THAT(rlp_readUInt256(&rlp, &value), testing::Eq(parser_ok));
+        EXPECT_TRUE(tostring256(&value, 10, out, sizeof(out)));
+        return out;
+    }
+
+    uint64_t small(const rlp_t &rlp) {
+        uint256_t value;
+        EXPECT_THAT(rlp_readUInt256(&rlp, &value), testing::Eq(parser_ok));
+        return value.elements[1].elements[1];
+    }
+}
+
+TEST(Policy, LimitsAtTheBoundary) {
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        const auto blob = decodeBlob(tc.blob);
+
+        parser_tx_t tx;
+        ASSERT_THAT(readBlob(blob, &tx), testing::Eq(parser_ok)) << tc.name;
+
+        const string value = decimal(tx.fields[MANTX_FIELD_VALUE]);
+        const rlp_t &data = tx.fields[MANTX_FIELD_DATA];
+        const uint64_t dataLen = data.kind == RLP_KIND_BYTE ? 1 : data.rlpLen;
+        const uint64_t commitTime = small(tx.fields[MANTX_FIELD_COMMITTIME + 2]);
+
+        const string allowed = "value <= " + value + "\n"
+                               "data <= " + to_string(dataLen) + "; txtype in " + to_string(tx.extraTxType) + ", 200\n"
+                               "recipients == " + to_string(tx.extraToFieldsItems) + "\n"
+                               "commit_age <= 300   # either side of now\n";
+        const policy_program_t program = compile(allowed);
+        ASSERT_THAT(program.count, testing::Eq(5));
+
+        policy_result_t result;
+        parser_tx_t checked;
+        ASSERT_THAT(policy_check(&program, blob.data(), (uint16_t) blob.size(), commitTime + 300, &checked, &result), testing::Eq(parser_ok));
+        EXPECT_TRUE(result.allowed) << tc.name << " rule " << (int) result.rule;
+        ASSERT_THAT(policy_eval(&program, &tx, commitTime - 300, &result), testing::Eq(parser_ok));
+        EXPECT_TRUE(result.allowed) << tc.name << " rule " << (int) result.rule;
+
+        // One step past each limit fails on that rule
+        ASSERT_THAT(policy_eval(&program, &tx, commitTime + 301, &result), testing::Eq(parser_ok));
+        EXPECT_FALSE(result.allowed);
+        EXPECT_THAT(result.rule, testing::Eq(4));
+
+        if (value != "0") {
+            const policy_program_t strict = compile("value < " + value);
+            ASSERT_THAT(policy_eval(&strict, &tx, 0, &result), testing::Eq(parser_ok));
+            EXPECT_FALSE(result.allowed) << tc.name;
+        }
+
+        const policy_program_t noType = compile("entrust >= 0; txtype != " + to_string(tx.extraTxType));
+        ASSERT_THAT(policy_eval(&noType, &tx, 0, &result), testing::Eq(parser_ok));
+        EXPECT_FALSE(result.allowed);
+        EXPECT_THAT(result.rule, testing::Eq(1));
+
+        // Recipient rules hold for every recipient, vacuously without any
+        const policy_program_t noRecipients = compile("amount < 0");
+        ASSERT_THAT(policy_eval(&noRecipients, &tx, 0, &result), testing::Eq(parser_ok));
+        EXPECT_THAT(result.allowed, testing::Eq(tx.extraToFieldsItems == 0)) << tc.name;
+    }
+}
+
+TEST(Policy, CheapRulesRunFirst) {
+    const policy_program_t program = compile("amount <= 5\nvalue <= 10\ntxtype in 0\n\n# comment\npayload <= 3;entrust == 0");
+    ASSERT_THAT(program.count, testing::Eq(5));
+    EXPECT_THAT(program.insns[0].field, testing::Eq(policy_field_txtype));
+    EXPECT_THAT(program.insns[0].rule, testing::Eq(2));
+    EXPECT_THAT(program.insns[1].field, testing::Eq(policy_field_entrust));
+    EXPECT_THAT(program.insns[2].field, testing::Eq(policy_field_value));
+    EXPECT_THAT(program.insns[3].field, testing::Eq(policy_field_amount));
+    EXPECT_THAT(program.insns[3].rule, testing::Eq(0));
+    EXPECT_THAT(program.insns[4].field, testing::Eq(policy_field_payload));
+    EXPECT_THAT(program.insns[4].rule, testing::Eq(3));
+
+    const policy_program_t empty = compile("  \n # nothing\n");
+    EXPECT_THAT(empty.count, testing::Eq(0));
+}
+
+TEST(Policy, CompileErrors) {
+    struct {
+        const char *rules;
+        parser_error_t err;
+        uint8_t rule;
+    } cases[] = {
+        {"value <= 1\nfee <= 1", parser_unexpected_field, 1},
+        {"value => 1", parser_unexpected_characters, 0},
+        {"value <= 1x", parser_unexpected_characters, 0},
+        {"value <=", parser_unexpected_characters, 0},
+        {"value in 1", parser_unexpected_field, 0},
+        {"txtype in 1, 256", parser_value_out_of_range, 0},
+        {"value <= 1000000000000000000000000000000000000000000000000000000000000000000000000000000",
+         parser_value_out_of_range, 0},
+    };
+    for (const auto &c : cases) {
+        policy_program_t program;
+        uint8_t errorRule = 0xFF;
+        EXPECT_THAT(policy_compile(c.rules, strlen(c.rules), &program, &errorRule), testing::Eq(c.err)) << c.rules;
+        EXPECT_THAT(errorRule, testing::Eq(c.rule)) << c.rules;
+    }
+
+    string tooMany;
+    for (uint32_t i = 0; i <= POLICY_MAX_RULES; i++) {
+        tooMany += "data <= 1\n";
+    }
+    policy_program_t program;
+    EXPECT_THAT(policy_compile(tooMany.c_str(), tooMany.size(), &program, nullptr),
+                testing::Eq(parser_unexpected_number_items));
+
+    // Anything below 2^252 compiles
+    const string big = "value <= 7237005577332262213973186563042994240829374041602535252466099000494570602495";
+    EXPECT_THAT(policy_compile(big.c_str(), big.size(), &program, nullptr), testing::Eq(parser_ok));
+}
@@ -18,6 +18,8 @@
 
 #include <iostream>
 #include <hexutils.h>
+#include <sstream>
+#include <fmt/core.h>
 
 #include "rlp.h"
 
@@ -68,6 +70,105 @@ TEST(RLP, RLPDecodingKind) {
     }
 }
 
+struct RLPUInt256Testcase {
+    const char *data;
+    const char *expectedValue;
+};
+
+TEST(RLP, RLPReadUInt256) {
+    vector<RLPUInt256Testcase> rlp_vec {
+        {"00", "0"},
+        {"7F", "127"},
+        {"80", "0"},
+        {"8180", "128"},
+        {"88FFFFFFFFFFFFFFFF", "18446744073709551615"},
+        {"89010000000000000000", "18446744073709551616"},
+        {"A0FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF",
+         "115792089237316195423570985008687907853269984665640564039457584007913129639935"},
+    };
+
+    rlp_t rlp;
+    for (const auto& testcase : rlp_vec) {
+        uint8_t buffer[100] = {0};
+        const auto bufferLen = parseHexString(buffer, sizeof(buffer), testcase.data);
+        parser_context_t ctx = {.buffer = buffer,
+                                .bufferLen = (uint16_t) bufferLen,
+                                .offset = 0,
+                                .tx_obj = NULL};
+        ASSERT_THAT(rlp_read(&ctx, &rlp), testing::Eq(parser_ok));
+
+        uint256_t value;
+        ASSERT_THAT(rlp_readUInt256(&rlp, &value), testing::Eq(parser_ok));
+
+        char out[100] = {0};
+        ASSERT_TRUE(tostring256(&value, 10, out, sizeof(out)));
+        EXPECT_THAT(std::string(out), testing::Eq(testcase.expectedValue)) << testcase.data;
+    }
+
+    // 33 bytes do not fit in a uint256
+    uint8_t buffer[100] = {0};
+    const auto bufferLen = parseHexString(buffer, sizeof(buffer),
+                                          "A1010000000000000000000000000000000000000000000000000000000000000000");
+    parser_context_t ctx = {.buffer = buffer, .bufferLen = (uint16_t) bufferLen, .offset = 0, .tx_obj = NULL};
+    ASSERT_THAT(rlp_read(&ctx, &rlp), testing::Eq(parser_ok));
+    uint256_t value;
+    EXPECT_THAT(rlp_readUInt256(&rlp, &value), testing::Eq(parser_value_out_of_range));
+}
+
+namespace {
+    parser_error_t dumpWalk(const rlp_walk_t *event, void *user) {
+        auto &ss = *static_cast<std::stringstream *>(user);
+        const string indent(event->depth, ' ');
+        switch (event->event) {
+            case RLP_WALK_ENTER_LIST:
+                ss << indent << "[" << event->offset << "+" << event->headerLen << ":" << event->item.rlpLen << "\n";
+                break;
+            case RLP_WALK_LEAVE_LIST:
+                ss << indent << "]\n";
+                break;
+            default:
+                ss << indent << event->offset << "+" << event->headerLen << ":" << event->item.rlpLen << "\n";
+                break;
+        }
+        return parser_ok;
+    }
+}
+
+TEST(RLP, RLPWalk) {
+    // [ "dog", [ [], 0x05 ], "" ] 0x01
+    uint8_t buffer[100] = {0};
+    auto bufferLen = (uint16_t) parseHexString(buffer, sizeof(buffer), "C883646F67C2C0058001");
+
+    std::stringstream ss;
+    ASSERT_THAT(rlp_walk(buffer, bufferLen, dumpWalk, &ss), testing::Eq(parser_ok));
+    EXPECT_THAT(ss.str(), testing::Eq("[0+1:8\n"
+                                      " 1+1:3\n"
+                                      " [5+1:2\n"
+                                      "  [6+1:0\n"
+                                      "  ]\n"
+                                      "  7+0:0\n"
+                                      " ]\n"
+                                      " 8+1:0\n"
+                                      "]\n"
+                                      "9+0:0\n"));
+
+    // A child running past its list
+    bufferLen = (uint16_t) parseHexString(buffer, sizeof(buffer), "C283646F67");
+    EXPECT_THAT(rlp_walk(buffer, bufferLen, dumpWalk, &ss), testing::Eq(parser_unexpected_buffer_end));
+
+    // Nesting deeper than the walker tracks
+    std::string nested;
+    for (uint16_t i = 0; i <= RLP_WALK_MAX_DEPTH; i++) {
+        nested.insert(0, fmt::format("{:02X}", 0xC0 + i));
+    }
+    bufferLen = (uint16_t) parseHexString(buffer, sizeof(buffer), nested.c_str());
+    EXPECT_THAT(rlp_walk(buffer, bufferLen, dumpWalk, &ss), testing::Eq(parser_rlp_too_deep));
+
+    // Callback errors stop the walk
+    auto stop = [](const rlp_walk_t *, void *) { return parser_unexpected_value; };
+    EXPECT_THAT(rlp_walk(buffer, bufferLen, stop, nullptr), testing::Eq(parser_unexpected_value));
+}
+
 #if 0
 ////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////
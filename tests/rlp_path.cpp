@@ -0,0 +1,135 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include <vector>
+#include <hexutils.h>
+#include "common.h"
+#include "parser_impl.h"
+#include "rlp.h"
+#include "rlp_path.h"
+
+using namespace std;
+
+namespace {
+    parser_error_t collect(rlp_path_match_t *match, void *user) {
+        static_cast<vector<rlp_path_match_t> *>(user)->push_back(*match);
+        return parser_ok;
+    }
+}
+
+TEST(RLPPath, Compile) {
+    rlp_path_t path;
+    ASSERT_THAT(rlp_path_compile("root", &path), testing::Eq(parser_ok));
+    EXPECT_THAT(path.stepCount, testing::Eq(0));
+
+    ASSERT_THAT(rlp_path_compile("root/12/0/2/*/1", &path), testing::Eq(parser_ok));
+    ASSERT_THAT(path.stepCount, testing::Eq(5));
+    EXPECT_THAT(path.steps[0], testing::Eq(12));
+    EXPECT_THAT(path.steps[3], testing::Eq(RLP_PATH_ANY));
+    EXPECT_THAT(path.steps[4], testing::Eq(1));
+
+    EXPECT_THAT(rlp_path_compile("", &path), testing::Eq(parser_unexpected_characters));
+    EXPECT_THAT(rlp_path_compile("root/", &path), testing::Eq(parser_unexpected_characters));
+    EXPECT_THAT(rlp_path_compile("root/1x", &path), testing::Eq(parser_unexpected_characters));
+    EXPECT_THAT(rlp_path_compile("root//1", &path), testing::Eq(parser_unexpected_characters));
+    EXPECT_THAT(rlp_path_compile("root/65535", &path), testing::Eq(parser_value_out_of_range));
+    EXPECT_THAT(rlp_path_compile("root/0/0/0/0/0/0/0/0/0/0/0/0/0/0/0/0/0", &path),
+                testing::Eq(parser_value_out_of_range));
+}
+
+TEST(RLPPath, MatchesRead) {
+    rlp_path_t nonce, txType, amounts, missing;
+    ASSERT_THAT(rlp_path_compile("root/0", &nonce), testing::Eq(parser_ok));
+    ASSERT_THAT(rlp_path_compile("root/12/0/0", &txType), testing::Eq(parser_ok));
+    ASSERT_THAT(rlp_path_compile("root/12/0/2/*/1", &amounts), testing::Eq(parser_ok));
+    ASSERT_THAT(rlp_path_compile("root/0/0", &missing), testing::Eq(parser_ok));
+
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        const auto blob = decodeBlob(tc.blob);
+        const auto blobLen = (uint16_t) blob.size();
+
+        parser_tx_t tx;
+        ASSERT_THAT(readBlob(blob, &tx), testing::Eq(parser_ok)) << tc.name;
+
+        rlp_t item;
+        ASSERT_THAT(rlp_path_first(&nonce, blob.data(), blobLen, &item), testing::Eq(parser_ok));
+        EXPECT_TRUE(sameSpan(item, tx.fields[MANTX_FIELD_NONCE])) << tc.name;
+        ASSERT_THAT(rlp_path_first(&txType, blob.data(), blobLen, &item), testing::Eq(parser_ok));
+        EXPECT_TRUE(sameSpan(item, tx.extraFields[0])) << tc.name;
+        EXPECT_THAT(rlp_path_first(&missing, blob.data(), blobLen, &item), testing::Eq(parser_missing_field));
+
+        vector<rlp_path_match_t> matches;
+        ASSERT_THAT(rlp_path_query(&amounts, blob.data(), blobLen, collect, &matches), testing::Eq(parser_ok));
+        ASSERT_THAT(matches.size(), testing::Eq(tx.extraToFieldsItems)) << tc.name;
+        for (uint16_t i = 0; i < tx.extraToFieldsItems; i++) {
+            rlp_t recipient[MANTX_EXTRATOFIELD_COUNT];
+            uint16_t items = 0;
+            ASSERT_THAT(rlp_readList(&tx.extraToListFields[i], recipient, &items, MANTX_EXTRATOFIELD_COUNT),
+                        testing::Eq(parser_ok));
+            EXPECT_TRUE(sameSpan(matches[i].item, recipient[1])) << tc.name;
+            EXPECT_THAT(matches[i].indices[3], testing::Eq(i));
+        }
+    }
+}
+
+TEST(RLPPath, Errors) {
+    rlp_path_t path;
+    ASSERT_THAT(rlp_path_compile("root/*", &path), testing::Eq(parser_ok));
+
+    // [ "dog", 0x05 ] with trailing bytes, then with a truncated child
+    uint8_t buffer[100];
+    auto bufferLen = (uint16_t) parseHexString(buffer, sizeof(buffer), "C583646F670501");
+    vector<rlp_path_match_t> matches;
+    EXPECT_THAT(rlp_path_query(&path, buffer, bufferLen, collect, &matches),
+                testing::Eq(parser_unexpected_unparsed_bytes));
+
+    bufferLen = (uint16_t) parseHexString(buffer, sizeof(buffer), "C485646F67");
+    EXPECT_THAT(rlp_path_query(&path, buffer, bufferLen, collect, &matches),
+                testing::Eq(parser_unexpected_buffer_end));
+
+    bufferLen = (uint16_t) parseHexString(buffer, sizeof(buffer), "C583646F6705");
+    auto fail = [](rlp_path_match_t *, void *) { return parser_unexpected_value; };
+    EXPECT_THAT(rlp_path_query(&path, buffer, bufferLen, fail, nullptr), testing::Eq(parser_unexpected_value));
+
+    // [ 0x05, "do" ] with the second child truncated: first stops before reaching it
+    bufferLen = (uint16_t) parseHexString(buffer, sizeof(buffer), "C305826F");
+    rlp_t item;
+    EXPECT_THAT(rlp_path_query(&path, buffer, bufferLen, collect, &matches), testing::Eq(parser_unexpected_buffer_end));
+    ASSERT_THAT(rlp_path_first(&path, buffer, bufferLen, &item), testing::Eq(parser_ok));
+    EXPECT_THAT(item.kind, testing::Eq(RLP_KIND_BYTE));
+    EXPECT_THAT(*item.ptr, testing::Eq(0x05));
+}
+
+TEST(RLPPath, StopFlag) {
+    rlp_path_t path;
+    ASSERT_THAT(rlp_path_compile("root/*", &path), testing::Eq(parser_ok));
+
+    // [ "dog", 0x05, "cat" ]: the callback ends the query at the second match
+    uint8_t buffer[100];
+    const auto bufferLen = (uint16_t) parseHexString(buffer, sizeof(buffer), "C983646F670583636174");
+    vector<rlp_path_match_t> matches;
+    auto takeTwo = [](rlp_path_match_t *match, void *user) {
+        auto *seen = static_cast<vector<rlp_path_match_t> *>(user);
+        seen->push_back(*match);
+        match->stop = seen->size() == 2;
+        return parser_ok;
+    };
+    ASSERT_THAT(rlp_path_query(&path, buffer, bufferLen, takeTwo, &matches), testing::Eq(parser_ok));
+    ASSERT_THAT(matches.size(), testing::Eq(2u));
+    EXPECT_THAT(matches[1].indices[0], testing::Eq(1));
+}
@@ -0,0 +1,172 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include <vector>
+#include <random>
+#include "common.h"
+#include "parser_impl.h"
+#include "rlp_segments.h"
+
+using namespace std;
+
+namespace {
+    bool sameItem(const rlp_t &a, const rlp_t &b) {
+        if (a.kind != b.kind || a.rlpLen != b.rlpLen) {
+            return false;
+        }
+        const size_t len = a.kind == RLP_KIND_BYTE ? 1 : a.rlpLen;
+        return len == 0 || memcmp(a.ptr, b.ptr, len) == 0;
+    }
+
+    void expectSameTx(const parser_tx_t &a, const parser_tx_t &b) {
+        ASSERT_THAT(a.rootFieldsItems, testing::Eq(b.rootFieldsItems));
+        ASSERT_THAT(a.extraFieldsItems, testing::Eq(b.extraFieldsItems));
+        ASSERT_THAT(a.extraToFieldsItems, testing::Eq(b.extraToFieldsItems));
+        EXPECT_THAT(a.extraTxType, testing::Eq(b.extraTxType));
+        for (uint16_t i = 0; i < a.rootFieldsItems; i++) {
+            EXPECT_TRUE(sameItem(a.fields[i], b.fields[i])) << "field " << i;
+        }
+        for (uint16_t i = 0; i < a.extraFieldsItems; i++) {
+            EXPECT_TRUE(sameItem(a.extraFields[i], b.extraFields[i])) << "extra " << i;
+        }
+        for (uint16_t i = 0; i < a.extraToFieldsItems; i++) {
+            EXPECT_TRUE(sameItem(a.extraToListFields[i], b.extraToListFields[i])) << "extraTo " << i;
+        }
+    }
+
+    bool insideSegments(const uint8_t *ptr, const vector<rlp_segment_t> &segments) {
+        for (const auto &s : segments) {
+            if (ptr >= s.ptr && ptr < s.ptr + s.len) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+TEST(RLPSegments, EveryTwoWaySplitMatchesRead) {
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        const auto blob = decodeBlob(tc.blob);
+        const auto blobLen = (uint16_t) blob.size();
+
+        parser_tx_t expected;
+        ASSERT_THAT(readBlob(blob, &expected), testing::Eq(parser_ok)) << tc.name;
+
+        for (uint16_t cut = 0; cut <= blobLen; cut++) {
+            // Fragments live in their own allocations
+            vector<uint8_t> first(blob.begin(), blob.begin() + cut);
+            vector<uint8_t> second(blob.begin() + cut, blob.end());
+            const vector<rlp_segment_t> segments = {{first.data(), (uint32_t) first.size()},
+                                                    {second.data(), (uint32_t) second.size()}};
+            uint8_t scratchBuffer[5000];
+            rlp_sg_scratch_t scratch = {scratchBuffer, sizeof(scratchBuffer), 0};
+
+            parser_tx_t tx;
+            ASSERT_THAT(rlp_sg_readTx(segments.data(), segments.size(), &scratch, &tx), testing::Eq(parser_ok))
+                << tc.name << " cut " << cut;
+            expectSameTx(tx, expected);
+
+            // Only the one root field that straddles the cut is gathered
+            uint16_t gathered = 0;
+            for (uint16_t i = 0; i < tx.rootFieldsItems; i++) {
+                if (tx.fields[i].rlpLen > 0 && !insideSegments(tx.fields[i].ptr, segments)) {
+                    gathered++;
+                }
+            }
+            EXPECT_LE(gathered, 1) << tc.name << " cut " << cut;
+        }
+    }
+}
+
+TEST(RLPSegments, RandomFragmentsMatchRead) {
+    mt19937 rng(1234);
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        const auto blob = decodeBlob(tc.blob);
+        const auto blobLen = (uint16_t) blob.size();
+
+        parser_tx_t expected;
+        ASSERT_THAT(readBlob(blob, &expected), testing::Eq(parser_ok));
+
+        for (int round = 0; round < 50; round++) {
+            // Fragments of 0..7 bytes, empty ones included
+            vector<vector<uint8_t>> chunks;
+            for (uint16_t offset = 0; offset < blobLen;) {
+                const uint16_t len = min<uint16_t>(rng() % 8, blobLen - offset);
+                chunks.emplace_back(blob.begin() + offset, blob.begin() + offset + len);
+                offset += len;
+            }
+            vector<rlp_segment_t> segments;
+            for (const auto &c : chunks) {
+                segments.push_back({c.data(), (uint32_t) c.size()});
+            }
+
+            uint8_t scratchBuffer[5000];
+            rlp_sg_scratch_t scratch = {scratchBuffer, sizeof(scratchBuffer), 0};
+            parser_tx_t tx;
+            ASSERT_THAT(rlp_sg_readTx(segments.data(), segments.size(), &scratch, &tx), testing::Eq(parser_ok));
+            expectSameTx(tx, expected);
+            EXPECT_LE(scratch.used, blobLen);
+        }
+    }
+}
+
+TEST(RLPSegments, NestedCursorsAndErrors) {
+    // [ "dog", [ "cat", 0x05 ] ]
+    const uint8_t fixed[] = {0xCA, 0x83, 'd', 'o', 'g', 0xC5, 0x83, 'c', 'a', 't', 0x05};
+
+    // Split inside "dog"
+    const rlp_segment_t segments[] = {{fixed, 3}, {fixed + 3, 8}};
+    uint8_t scratchBuffer[4];
+    rlp_sg_scratch_t scratch = {scratchBuffer, sizeof(scratchBuffer), 0};
+
+    rlp_sg_t sg, root, inner;
+    rlp_t item;
+    ASSERT_THAT(rlp_sg_init(&sg, segments, 2, &scratch), testing::Eq(parser_ok));
+    ASSERT_THAT(rlp_sg_read(&sg, &item, &root), testing::Eq(parser_ok));
+    EXPECT_THAT(item.kind, testing::Eq(RLP_KIND_LIST));
+    EXPECT_TRUE(item.ptr == nullptr);
+    EXPECT_TRUE(rlp_sg_done(&sg));
+
+    ASSERT_THAT(rlp_sg_read(&root, &item, nullptr), testing::Eq(parser_ok));
+    EXPECT_THAT(string((const char *) item.ptr, item.rlpLen), testing::Eq("dog"));
+    EXPECT_TRUE(item.ptr == scratchBuffer);
+
+    ASSERT_THAT(rlp_sg_read(&root, &item, &inner), testing::Eq(parser_ok));
+    EXPECT_THAT(item.kind, testing::Eq(RLP_KIND_LIST));
+    EXPECT_TRUE(item.ptr == fixed + 6);
+    EXPECT_TRUE(rlp_sg_done(&root));
+
+    ASSERT_THAT(rlp_sg_read(&inner, &item, nullptr), testing::Eq(parser_ok));
+    EXPECT_THAT(string((const char *) item.ptr, item.rlpLen), testing::Eq("cat"));
+    EXPECT_TRUE(item.ptr == fixed + 7);
+    ASSERT_THAT(rlp_sg_read(&inner, &item, nullptr), testing::Eq(parser_ok));
+    EXPECT_THAT(item.kind, testing::Eq(RLP_KIND_BYTE));
+    EXPECT_THAT(*item.ptr, testing::Eq(0x05));
+    EXPECT_TRUE(rlp_sg_done(&inner));
+    EXPECT_THAT(rlp_sg_read(&inner, &item, nullptr), testing::Eq(parser_unexpected_buffer_end));
+
+    // Not enough scratch for a straddling string
+    rlp_sg_scratch_t small = {scratchBuffer, 2, 0};
+    ASSERT_THAT(rlp_sg_init(&sg, segments, 2, &small), testing::Eq(parser_ok));
+    ASSERT_THAT(rlp_sg_read(&sg, &item, &root), testing::Eq(parser_ok));
+    EXPECT_THAT(rlp_sg_read(&root, &item, nullptr), testing::Eq(parser_scratch_exhausted));
+
+    // Truncated input
+    ASSERT_THAT(rlp_sg_init(&sg, segments, 1, &scratch), testing::Eq(parser_ok));
+    EXPECT_THAT(rlp_sg_read(&sg, &item, &root), testing::Eq(parser_unexpected_buffer_end));
+}
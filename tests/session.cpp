@@ -0,0 +1,139 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "common.h"
+#include "parser.h"
+#include "session.h"
+
+using namespace std;
+
+TEST(Session, RendersLikeParser) {
+    vector<parser_session_t> storage(2);
+    session_pool_t pool;
+    ASSERT_THAT(session_pool_init(&pool, storage.data(), (uint32_t) storage.size()), testing::Eq(zxerr_ok));
+    parser_session_t *session = session_acquire(&pool);
+    ASSERT_TRUE(session != nullptr);
+
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        // The same session for every transaction, never cleared in between
+        ASSERT_THAT(session_parseHex(session, tc.blob.c_str(), tc.blob.size()), testing::Eq(parser_ok)) << tc.name;
+        ASSERT_THAT(session_validate(session), testing::Eq(parser_ok)) << tc.name;
+
+        const auto blob = decodeBlob(tc.blob);
+        parser_context_t ctx;
+        ASSERT_THAT(parser_parse(&ctx, blob.data(), blob.size()), testing::Eq(parser_ok));
+
+        uint8_t numItems = 0;
+        ASSERT_THAT(parser_getNumItems(&ctx, &numItems), testing::Eq(parser_ok));
+        for (uint8_t idx = 0; idx < numItems; idx++) {
+            char key[SESSION_KEY_LEN];
+            char value[SESSION_VALUE_LEN];
+            uint8_t pageCount = 1;
+            for (uint8_t page = 0; page < pageCount; page++) {
+                uint8_t sessionPages = 0;
+                const auto err = parser_getItem(&ctx, idx, key, sizeof(key), value, sizeof(value), page, &pageCount);
+                ASSERT_THAT(session_getItem(session, idx, page, &sessionPages), testing::Eq(err));
+                EXPECT_THAT(sessionPages, testing::Eq(pageCount));
+                EXPECT_STREQ(session->key, key);
+                EXPECT_STREQ(session->value, value);
+            }
+        }
+    }
+
+    // A failed parse leaves nothing to show
+    EXPECT_THAT(session_parseHex(session, "C180", 4), testing::Eq(parser_unexpected_number_items));
+    uint8_t pageCount = 0;
+    EXPECT_THAT(session_getItem(session, 0, 0, &pageCount), testing::Eq(parser_no_data));
+    EXPECT_THAT(session_parseHex(session, "C1X0", 4), testing::Eq(parser_unexpected_characters));
+    EXPECT_THAT(session_parseHex(session, "C18", 3), testing::Eq(parser_unexpected_characters));
+}
+
+TEST(Session, HandlesGoStale) {
+    vector<parser_session_t> storage(1);
+    session_pool_t pool;
+    ASSERT_THAT(session_pool_init(&pool, storage.data(), 1), testing::Eq(zxerr_ok));
+    parser_session_t *session = session_acquire(&pool);
+    ASSERT_TRUE(session != nullptr);
+    EXPECT_TRUE(session_acquire(&pool) == nullptr);
+
+    const auto tc = GetJsonTestCases("testcases.json").front();
+    ASSERT_THAT(session_parseHex(session, tc.blob.c_str(), tc.blob.size()), testing::Eq(parser_ok));
+    const session_handle_t first = session_handle(session);
+    EXPECT_TRUE(session_isCurrent(first));
+
+    ASSERT_THAT(session_parseHex(session, tc.blob.c_str(), tc.blob.size()), testing::Eq(parser_ok));
+    EXPECT_FALSE(session_isCurrent(first));
+    const session_handle_t second = session_handle(session);
+    EXPECT_TRUE(session_isCurrent(second));
+
+    session_release(&pool, session);
+    EXPECT_FALSE(session_isCurrent(second));
+    EXPECT_TRUE(session_acquire(&pool) == session);
+}
+
+TEST(Session, PoolIsSharedSafely) {
+    const uint32_t sessions = 4;
+    vector<parser_session_t> storage(sessions);
+    session_pool_t pool;
+    ASSERT_THAT(session_pool_init(&pool, storage.data(), sessions), testing::Eq(zxerr_ok));
+
+    const auto testcases = GetJsonTestCases("testcases.json");
+    vector<atomic<int>> owners(sessions);
+    atomic<uint32_t> overlaps(0), parsed(0), failures(0);
+
+    vector<thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 2000; i++) {
+                parser_session_t *s = session_acquire(&pool);
+                if (s == nullptr) {
+                    continue;
+                }
+                const size_t idx = (size_t) (s - storage.data());
+                if (owners[idx].fetch_add(1) != 0) {
+                    overlaps++;
+                }
+                const auto &tc = testcases[(size_t) (t + i) % testcases.size()];
+                if (session_parseHex(s, tc.blob.c_str(), tc.blob.size()) != parser_ok ||
+                    session_validate(s) != parser_ok) {
+                    failures++;
+                }
+                parsed++;
+                owners[idx].fetch_sub(1);
+                session_release(&pool, s);
+            }
+        });
+    }
+    for (auto &th : threads) {
+        th.join();
+    }
+
+    EXPECT_THAT(overlaps.load(), testing::Eq(0u));
+    EXPECT_THAT(failures.load(), testing::Eq(0u));
+    EXPECT_THAT(parsed.load(), testing::Gt(0u));
+
+    // Every session came back
+    vector<parser_session_t *> all;
+    while (parser_session_t *s = session_acquire(&pool)) {
+        all.push_back(s);
+    }
+    EXPECT_THAT(all.size(), testing::Eq(sessions));
+}
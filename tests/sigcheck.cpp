@@ -0,0 +1,252 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <random>
+#include <hexutils.h>
+#include "coin.h"
+#include "common.h"
+#include "crypto_helper.h"
+#include "keccak.h"
+#include "parser_impl.h"
+#include "sigcheck.h"
+
+using namespace std;
+
+namespace {
+    // RLP string of a big endian integer, leading zeros stripped
+    vector<uint8_t> rlpInteger(const uint8_t *data, size_t len) {
+        while (len > 0 && *data == 0) {
+            data++;
+            len--;
+        }
+        vector<uint8_t> out;
+        if (len == 1 && data[0] < 0x80) {
+            out.push_back(data[0]);
+            return out;
+        }
+        out.push_back(0x80 + len);
+        out.insert(out.end(), data, data + len);
+        return out;
+    }
+}
+
+TEST(Sigcheck, RecoversEip155Vector) {
+    // EIP-155 example: private key 0x4646..46, chain id 1
+    sigcheck_sig_t sig;
+    parseHexString(sig.digest, sizeof(sig.digest), "daf5a779ae972f972197303d7b574746c7ef83eadac0f2791ad23db92e4c8e53");
+    parseHexString(sig.r, sizeof(sig.r), "28ef61340bd939bc2195fe537567866003e1a15d3c71ff63e1590620aa636276");
+    parseHexString(sig.s, sizeof(sig.s), "67cbe9d8997f761aecb703304b3800ccf555c9f3dc64214b297fb1966a3b6d83");
+    sig.recid = 37 - SIGCHECK_EIP155_OFFSET - 2;
+
+    uint8_t pubkey[1][SIGCHECK_PUBKEY_LEN];
+    ASSERT_TRUE(sigcheck_recover(&sig, pubkey[0]));
+
+    uint8_t hash[KECCAK_HASH_SIZE];
+    uint8_t expected[ETH_ADDRESS_LEN];
+    keccak_hash(pubkey[0], SIGCHECK_PUBKEY_LEN, hash, sizeof(hash));
+    parseHexString(expected, sizeof(expected), "9d8a62f656a8d1615c1294fd71e9cfb3e4855a4f");
+    EXPECT_THAT(vector<uint8_t>(hash + 12, hash + 32), testing::ElementsAreArray(expected));
+
+    EXPECT_THAT(vector<uint8_t>(pubkey[0], pubkey[0] + SIGCHECK_PUBKEY_LEN),
+                testing::ElementsAreArray(decodeBlob("4bc2a31265153f07e70e0bab08724e6b85e217f8cd628ceb62974247bb493382"
+                                                  "ce28cab79ad7119ee1ad3ebcdb98a16805211530ecc6cfefa1b88e6dff99232a")));
+    EXPECT_TRUE(sigcheck_verify(&sig, pubkey[0]));
+
+    sig.digest[0] ^= 1;
+    EXPECT_FALSE(sigcheck_verify(&sig, pubkey[0]));
+}
+
+TEST(Sigcheck, RejectsHighS) {
+    // Same EIP-155 signature, malleated: (r, n - s) with the other parity recovers the same key
+    sigcheck_sig_t sig;
+    parseHexString(sig.digest, sizeof(sig.digest), "daf5a779ae972f972197303d7b574746c7ef83eadac0f2791ad23db92e4c8e53");
+    parseHexString(sig.r, sizeof(sig.r), "28ef61340bd939bc2195fe537567866003e1a15d3c71ff63e1590620aa636276");
+    parseHexString(sig.s, sizeof(sig.s), "67cbe9d8997f761aecb703304b3800ccf555c9f3dc64214b297fb1966a3b6d83");
+    sig.recid = 0;
+
+    uint8_t pubkey[SIGCHECK_PUBKEY_LEN];
+    ASSERT_TRUE(sigcheck_recover(&sig, pubkey));
+    ASSERT_TRUE(sigcheck_verify(&sig, pubkey));
+
+    const auto n = decodeBlob("fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141");
+    int borrow = 0;
+    for (int i = SIGCHECK_SCALAR_LEN - 1; i >= 0; i--) {
+        const int diff = n[i] - sig.s[i] - borrow;
+        sig.s[i] = (uint8_t) diff;
+        borrow = diff < 0;
+    }
+    sig.recid ^= 1;
+
+    uint8_t malleated[SIGCHECK_PUBKEY_LEN];
+    EXPECT_FALSE(sigcheck_recover(&sig, malleated));
+    EXPECT_FALSE(sigcheck_verify(&sig, pubkey));
+
+    uint8_t address[1][ADDRESS_LEN];
+    uint8_t addressLen = 1;
+    bool valid = true;
+    ASSERT_THAT(sigcheck_recoverAddresses(&sig, address, &addressLen, &valid, 1), testing::Eq(zxerr_ok));
+    EXPECT_FALSE(valid);
+    EXPECT_THAT(addressLen, testing::Eq(0));
+}
+
+TEST(Sigcheck, SignedTxRoundTrip) {
+    // Example1 as sent to the device: V = chainId 3, R and S empty
+    const string head = "8710000000000008850430e23400825208a14d414e2e32556f7a3867386a61754d61326d746e7778727363686a3271504a72458398968080";
+    const string tail = "8080845c3d93c9c4c38080c0";
+    const vector<uint8_t> unsignedTx = decodeBlob("f847" + head + "03" + "8080" + tail);
+
+    // Signed offline with private key 0x1111..11
+    const auto pubkey = decodeBlob("4f355bdcb7cc0af728ef3cceb9615d90684bb5b2ca5f859ab0f0b704075871aa"
+                                "385b6b1b8ead809ca67454d9683fcf2ba03456d6fe2c4abe2b07f0fbdbb2f1c1");
+    sigcheck_sig_t signature;
+    keccak_hash(unsignedTx.data(), unsignedTx.size(), signature.digest, sizeof(signature.digest));
+    ASSERT_THAT(vector<uint8_t>(signature.digest, signature.digest + 32),
+                testing::ElementsAreArray(decodeBlob("785546b669e39818d6004f47757f0e0f95b13e4c84e22a0f5d3cda371ab0cf29")));
+    parseHexString(signature.r, sizeof(signature.r), "35a72921ffd1064155e5b6e87a5580cbb2f037d472a8857315dbf7d5dbbeaa2b");
+    parseHexString(signature.s, sizeof(signature.s), "6ccabffd53fad275e4f8b0a56d04fa4d8e9ed6d28878c325e975cb70d8ccc46c");
+    signature.recid = 1;
+    ASSERT_TRUE(sigcheck_verify(&signature, pubkey.data()));
+
+    // Signed form: V = 35 + 2 * 3 + recid, R, S
+    vector<uint8_t> payload = decodeBlob(head);
+    payload.push_back(SIGCHECK_EIP155_OFFSET + 2 * 3 + signature.recid);
+    const auto r = rlpInteger(signature.r, sizeof(signature.r));
+    const auto s = rlpInteger(signature.s, sizeof(signature.s));
+    payload.insert(payload.end(), r.begin(), r.end());
+    payload.insert(payload.end(), s.begin(), s.end());
+    const auto tailBytes = decodeBlob(tail);
+    payload.insert(payload.end(), tailBytes.begin(), tailBytes.end());
+    vector<uint8_t> signedTx = {0xf8, (uint8_t) payload.size()};
+    signedTx.insert(signedTx.end(), payload.begin(), payload.end());
+
+    sigcheck_sig_t fromTx;
+    uint64_t chainId = 0;
+    ASSERT_THAT(sigcheck_readSignedTx(signedTx.data(), signedTx.size(), &fromTx, &chainId), testing::Eq(parser_ok));
+    EXPECT_THAT(chainId, testing::Eq(3u));
+    EXPECT_THAT(fromTx.recid, testing::Eq(signature.recid));
+    EXPECT_THAT(vector<uint8_t>(fromTx.digest, fromTx.digest + 32), testing::ElementsAreArray(signature.digest));
+
+    // Fused scan: hash of the signed bytes and of the signing form
+    parser_tx_t tx;
+    sigcheck_hashes_t hashes;
+    uint8_t signedHash[KECCAK_HASH_SIZE];
+    keccak_hash(signedTx.data(), signedTx.size(), signedHash, sizeof(signedHash));
+    ASSERT_THAT(sigcheck_parseTx(signedTx.data(), signedTx.size(), &tx, &hashes), testing::Eq(parser_ok));
+    EXPECT_TRUE(hashes.isSigned);
+    EXPECT_THAT(hashes.chainId, testing::Eq(3u));
+    EXPECT_THAT(vector<uint8_t>(hashes.txHash, hashes.txHash + 32), testing::ElementsAreArray(signedHash));
+    EXPECT_THAT(vector<uint8_t>(hashes.signingHash, hashes.signingHash + 32), testing::ElementsAreArray(signature.digest));
+
+    uint8_t address[1][ADDRESS_LEN];
+    uint8_t addressLen = 0;
+    bool valid = false;
+    ASSERT_THAT(sigcheck_recoverAddresses(&fromTx, address, &addressLen, &valid, 1), testing::Eq(zxerr_ok));
+    ASSERT_TRUE(valid);
+
+    uint8_t expected[ADDRESS_LEN];
+    const uint8_t expectedLen = crypto_encodePubkey(expected, sizeof(expected), pubkey.data());
+    ASSERT_THAT(addressLen, testing::Eq(expectedLen));
+    EXPECT_THAT(vector<uint8_t>(address[0], address[0] + addressLen),
+                testing::ElementsAreArray(expected, expectedLen));
+
+    // An unsigned transaction has no V to recover from
+    EXPECT_THAT(sigcheck_readSignedTx(unsignedTx.data(), unsignedTx.size(), &fromTx, nullptr),
+                testing::Eq(parser_unexpected_value));
+}
+
+TEST(Sigcheck, ParseTxMatchesRead) {
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        const auto blob = decodeBlob(tc.blob);
+
+        parser_tx_t expected;
+        ASSERT_THAT(readBlob(blob, &expected), testing::Eq(parser_ok)) << tc.name;
+
+        parser_tx_t tx;
+        sigcheck_hashes_t hashes;
+        ASSERT_THAT(sigcheck_parseTx(blob.data(), (uint16_t) blob.size(), &tx, &hashes), testing::Eq(parser_ok)) << tc.name;
+        EXPECT_THAT(memcmp(&tx, &expected, sizeof(tx)), testing::Eq(0)) << tc.name;
+
+        // Unsigned: both hashes are the hash of the blob
+        uint8_t hash[KECCAK_HASH_SIZE];
+        keccak_hash(blob.data(), blob.size(), hash, sizeof(hash));
+        EXPECT_FALSE(hashes.isSigned);
+        EXPECT_THAT(vector<uint8_t>(hashes.txHash, hashes.txHash + 32), testing::ElementsAreArray(hash));
+        EXPECT_THAT(vector<uint8_t>(hashes.signingHash, hashes.signingHash + 32), testing::ElementsAreArray(hash));
+    }
+}
+
+TEST(Sigcheck, BatchMatchesSingle) {
+    const uint16_t count = 200;
+    mt19937 rng(0x5eed);
+    vector<sigcheck_sig_t> sigs(count);
+    vector<array<uint8_t, SIGCHECK_PUBKEY_LEN>> pubkeys(count);
+
+    // Any (digest, r, s) that recovers to a key is a valid signature by that key,
+    // so random answers are drawn until one recovers on its own
+    for (uint16_t i = 0; i < count; i++) {
+        bool valid = false;
+        while (!valid) {
+            uint8_t message[40];
+            uint8_t rsv[SIGCHECK_RSV_LEN];
+            for (auto &b : message) b = rng();
+            for (auto &b : rsv) b = rng();
+            rsv[0] &= 0x7F;
+            rsv[SIGCHECK_SCALAR_LEN] &= 0x7F;
+            rsv[2 * SIGCHECK_SCALAR_LEN] = 27 + (rsv[2 * SIGCHECK_SCALAR_LEN] & 1);
+
+            // Same signature as the device would return it
+            ASSERT_THAT(sigcheck_readSignature(message, sizeof(message), rsv, &sigs[i]), testing::Eq(zxerr_ok));
+            valid = sigcheck_recover(&sigs[i], pubkeys[i].data());
+        }
+    }
+    // Corrupt a few: r = 0 and a flipped s
+    memset(sigs[5].r, 0, SIGCHECK_SCALAR_LEN);
+    sigs[77].s[31] ^= 1;
+
+    vector<array<uint8_t, ADDRESS_LEN>> addresses(count);
+    vector<uint8_t> addressLens(count);
+    unique_ptr<bool[]> recovered(new bool[count]);
+
+    ASSERT_THAT(sigcheck_recoverAddresses(sigs.data(),
+                                          reinterpret_cast<uint8_t (*)[ADDRESS_LEN]>(addresses.data()),
+                                          addressLens.data(), recovered.get(), count), testing::Eq(zxerr_ok));
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t expected[ADDRESS_LEN];
+        const uint8_t expectedLen = crypto_encodePubkey(expected, sizeof(expected), pubkeys[i].data());
+        const bool matches = recovered[i] && addressLens[i] == expectedLen &&
+                             memcmp(addresses[i].data(), expected, expectedLen) == 0;
+        const bool verified = sigcheck_verify(&sigs[i], pubkeys[i].data());
+
+        if (i == 5) {
+            EXPECT_FALSE(recovered[i]);
+            EXPECT_THAT(addressLens[i], testing::Eq(0));
+            EXPECT_FALSE(verified);
+        } else if (i == 77) {
+            // Still recovers, to somebody else
+            EXPECT_FALSE(matches);
+            EXPECT_FALSE(verified);
+        } else {
+            EXPECT_TRUE(matches) << i;
+            EXPECT_TRUE(verified) << i;
+        }
+    }
+}
@@ -0,0 +1,128 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "common.h"
+#include "trace.h"
+#include "parser.h"
+
+using namespace std;
+
+TEST(Trace, RingKeepsNewestRecordsInOrder) {
+    trace_reset();
+    vector<trace_record_t> records(TRACE_CAPACITY);
+    EXPECT_THAT(trace_snapshot(records.data(), records.size()), testing::Eq(0u));
+
+    const uint32_t total = TRACE_CAPACITY + 10;
+    for (uint32_t i = 0; i < total; i++) {
+        trace_record(trace_ev_rlp_read, i, i * 2, parser_ok);
+    }
+    ASSERT_THAT(trace_snapshot(records.data(), records.size()), testing::Eq((size_t) TRACE_CAPACITY));
+    for (uint32_t i = 0; i < TRACE_CAPACITY; i++) {
+        EXPECT_THAT(records[i].seq, testing::Eq(i + 10));
+        EXPECT_THAT(records[i].offset, testing::Eq(i + 10));
+    }
+
+    // A short buffer gets the newest ones
+    trace_record_t last[2];
+    ASSERT_THAT(trace_snapshot(last, 2), testing::Eq(2u));
+    EXPECT_THAT(last[1].seq, testing::Eq(total - 1));
+    EXPECT_THAT(last[0].seq, testing::Eq(total - 2));
+
+    // Other threads have their own ring
+    thread([]() {
+        trace_record_t r;
+        EXPECT_THAT(trace_snapshot(&r, 1), testing::Eq(0u));
+    }).join();
+
+    trace_reset();
+    EXPECT_THAT(trace_snapshot(records.data(), records.size()), testing::Eq(0u));
+}
+
+TEST(Trace, DumpFormat) {
+    trace_reset();
+    trace_record(trace_ev_read, 0, 77, parser_unexpected_buffer_end);
+    trace_record(trace_ev_check_error, 123, trace_file_rlp, parser_rlp_too_deep);
+
+    const string path = tempPath("mantx_trace");
+    ASSERT_THAT(trace_dump(path.c_str()), testing::Eq(0));
+
+    FILE *f = fopen(path.c_str(), "rb");
+    ASSERT_TRUE(f != nullptr);
+    vector<uint8_t> data(1024);
+    data.resize(fread(data.data(), 1, data.size(), f));
+    fclose(f);
+    remove(path.c_str());
+
+    ASSERT_THAT(data.size(), testing::Eq(TRACE_MAGIC_LEN + 8 + 2 * sizeof(trace_record_t)));
+    EXPECT_THAT(memcmp(data.data(), TRACE_MAGIC, TRACE_MAGIC_LEN), testing::Eq(0));
+    uint32_t header[2];
+    memcpy(header, data.data() + TRACE_MAGIC_LEN, sizeof(header));
+    EXPECT_THAT(header[0], testing::Eq(TRACE_VERSION));
+    EXPECT_THAT(header[1], testing::Eq(2u));
+
+    trace_record_t r;
+    memcpy(&r, data.data() + TRACE_MAGIC_LEN + 8 + sizeof(r), sizeof(r));
+    EXPECT_THAT(r.event, testing::Eq(trace_ev_check_error));
+    EXPECT_THAT(r.error, testing::Eq(parser_rlp_too_deep));
+    EXPECT_THAT(r.offset, testing::Eq(123u));
+    EXPECT_THAT(r.len, testing::Eq((uint32_t) trace_file_rlp));
+    EXPECT_THAT(r.seq, testing::Eq(1u));
+    trace_reset();
+}
+
+#ifdef PARSER_TRACE
+TEST(Trace, ParserIsInstrumented) {
+    const auto testcases = GetJsonTestCases("testcases.json");
+    ASSERT_FALSE(testcases.empty());
+    const auto blob = decodeBlob(testcases[0].blob);
+
+    vector<trace_record_t> records(TRACE_CAPACITY);
+    trace_reset();
+    parser_context_t ctx;
+    ASSERT_THAT(parser_parse(&ctx, blob.data(), blob.size()), testing::Eq(parser_ok));
+    size_t count = trace_snapshot(records.data(), records.size());
+    ASSERT_THAT(count, testing::Gt(0u));
+    EXPECT_THAT(records[count - 1].event, testing::Eq(trace_ev_read));
+    EXPECT_THAT(records[count - 1].len, testing::Eq((uint32_t) blob.size()));
+    EXPECT_THAT(records[count - 1].error, testing::Eq(parser_ok));
+
+    // Truncated: the failing CHECK_ERROR is recorded, then the failed read
+    trace_reset();
+    ASSERT_THAT(parser_parse(&ctx, blob.data(), blob.size() - 1), testing::Ne(parser_ok));
+    count = trace_snapshot(records.data(), records.size());
+    ASSERT_THAT(count, testing::Ge(2u));
+    const trace_record_t &read = records[count - 1];
+    EXPECT_THAT(read.event, testing::Eq(trace_ev_read));
+    EXPECT_THAT(read.error, testing::Ne(parser_ok));
+
+    bool sawCheck = false;
+    for (size_t i = 0; i + 1 < count; i++) {
+        if (records[i].event == trace_ev_check_error) {
+            sawCheck = true;
+            EXPECT_THAT(records[i].offset, testing::Gt(0u));
+            EXPECT_THAT(records[i].len, testing::Ne((uint32_t) trace_file_other));
+        }
+    }
+    EXPECT_TRUE(sawCheck);
+    trace_reset();
+}
+#endif
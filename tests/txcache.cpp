@@ -0,0 +1,195 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include <cstring>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <hexutils.h>
+#include "common.h"
+#include "parser.h"
+#include "txcache.h"
+
+using namespace std;
+
+namespace {
+    // Same shard and home slot for every n
+    vector<uint8_t> collidingHash(uint8_t n) {
+        vector<uint8_t> hash(KECCAK_HASH_SIZE, 0);
+        hash[KECCAK_HASH_SIZE - 1] = n;
+        return hash;
+    }
+}
+
+TEST(TxCache, RepeatedBlobsHit) {
+    vector<txcache_slot_t> slots(256);
+    txcache_t cache;
+    ASSERT_THAT(txcache_init(&cache, slots.data(), slots.size(), nullptr, 0), testing::Eq(zxerr_ok));
+
+    const auto testcases = GetJsonTestCases("testcases.json");
+    set<string> unique;
+    for (const auto &tc : testcases) {
+        unique.insert(tc.blob);
+    }
+    for (int round = 0; round < 2; round++) {
+        for (const auto &tc : testcases) {
+            const auto blob = decodeBlob(tc.blob);
+
+            txcache_entry_t entry;
+            EXPECT_THAT(txcache_check(&cache, blob.data(), blob.size(), &entry), testing::Eq(parser_ok)) << tc.name;
+            EXPECT_THAT(entry.parseError, testing::Eq(parser_ok));
+            EXPECT_THAT(entry.validateError, testing::Eq(parser_ok));
+        }
+    }
+
+    // A truncated blob is a different key and its failure is cached too
+    const auto blob = decodeBlob(testcases[0].blob);
+    txcache_entry_t entry;
+    const parser_error_t err = txcache_check(&cache, blob.data(), blob.size() - 1, &entry);
+    EXPECT_THAT(err, testing::Ne(parser_ok));
+    EXPECT_THAT(entry.validateError, testing::Eq(parser_no_data));
+    EXPECT_THAT(txcache_check(&cache, blob.data(), blob.size() - 1, &entry), testing::Eq(err));
+
+    txcache_stats_t stats;
+    txcache_stats(&cache, &stats);
+    EXPECT_THAT(stats.misses, testing::Eq(unique.size() + 1));
+    EXPECT_THAT(stats.hits, testing::Eq(2 * testcases.size() - unique.size() + 1));
+    EXPECT_THAT(stats.inserts, testing::Eq(unique.size() + 1));
+    EXPECT_THAT(stats.evictions, testing::Eq(0u));
+    txcache_destroy(&cache);
+}
+
+TEST(TxCache, RejectsOversizedBlobs) {
+    vector<txcache_slot_t> slots(16);
+    txcache_t cache;
+    ASSERT_THAT(txcache_init(&cache, slots.data(), slots.size(), nullptr, 0), testing::Eq(zxerr_ok));
+
+    // A valid 73 byte transaction followed by 65536 junk bytes: narrowed to uint16_t,
+    // the length would be 73 again and the junk would go unnoticed
+    vector<uint8_t> blob(73 + 65536, 0xAA);
+    const char *tx = "f8478710000000000008850430e23400825208a14d414e2e32556f7a3867386a61754d61326d746e7778727363686a"
+                     "3271504a724583989680800380808080845c3d93c9c4c38080c0";
+    ASSERT_THAT(parseHexString(blob.data(), 73, tx), testing::Eq(73u));
+
+    txcache_entry_t entry;
+    ASSERT_THAT(txcache_check(&cache, blob.data(), 73, &entry), testing::Eq(parser_ok));
+    EXPECT_THAT(txcache_check(&cache, blob.data(), blob.size(), &entry), testing::Eq(parser_value_out_of_range));
+    EXPECT_THAT(entry.parseError, testing::Eq(parser_value_out_of_range));
+
+    txcache_stats_t stats;
+    txcache_stats(&cache, &stats);
+    EXPECT_THAT(stats.inserts, testing::Eq(1u));
+    txcache_destroy(&cache);
+}
+
+TEST(TxCache, RenderedItems) {
+    vector<txcache_slot_t> slots(TXCACHE_SHARDS);
+    vector<uint8_t> store(TXCACHE_SHARDS * 16);
+    txcache_t cache;
+    ASSERT_THAT(txcache_init(&cache, slots.data(), slots.size(), store.data(), 16), testing::Eq(zxerr_ok));
+
+    const auto a = collidingHash(1);
+    const auto b = collidingHash(2);
+    const char rendered[] = "0 | Nonce : 5";
+    txcache_put(&cache, a.data(), parser_ok, parser_ok, (const uint8_t *) rendered, sizeof(rendered));
+
+    char out[32] = {0};
+    txcache_entry_t entry;
+    ASSERT_TRUE(txcache_get(&cache, a.data(), &entry, (uint8_t *) out, sizeof(out)));
+    EXPECT_THAT(entry.renderedLen, testing::Eq(sizeof(rendered)));
+    EXPECT_STREQ(out, rendered);
+
+    // Too small an output buffer: the result without the items
+    ASSERT_TRUE(txcache_get(&cache, a.data(), &entry, (uint8_t *) out, 4));
+    EXPECT_THAT(entry.renderedLen, testing::Eq(0u));
+
+    // Larger than a render slot: dropped, the result is still kept
+    const char longer[] = "0 | Nonce : 123456789";
+    txcache_put(&cache, a.data(), parser_ok, parser_unexpected_value, (const uint8_t *) longer, sizeof(longer));
+    ASSERT_TRUE(txcache_get(&cache, a.data(), &entry, (uint8_t *) out, sizeof(out)));
+    EXPECT_THAT(entry.validateError, testing::Eq(parser_unexpected_value));
+    EXPECT_THAT(entry.renderedLen, testing::Eq(0u));
+
+    EXPECT_FALSE(txcache_get(&cache, b.data(), &entry, nullptr, 0));
+    txcache_destroy(&cache);
+}
+
+TEST(TxCache, ClockGivesHitEntriesASecondChance) {
+    vector<txcache_slot_t> slots(TXCACHE_SHARDS * TXCACHE_PROBE);
+    txcache_t cache;
+    ASSERT_THAT(txcache_init(&cache, slots.data(), slots.size(), nullptr, 0), testing::Eq(zxerr_ok));
+
+    // Fill the probe window of one home slot
+    for (uint8_t n = 0; n < TXCACHE_PROBE; n++) {
+        txcache_put(&cache, collidingHash(n).data(), parser_ok, parser_ok, nullptr, 0);
+    }
+    txcache_entry_t entry;
+    ASSERT_TRUE(txcache_get(&cache, collidingHash(0).data(), &entry, nullptr, 0));
+
+    txcache_put(&cache, collidingHash(100).data(), parser_ok, parser_ok, nullptr, 0);
+    EXPECT_TRUE(txcache_get(&cache, collidingHash(100).data(), &entry, nullptr, 0));
+    EXPECT_TRUE(txcache_get(&cache, collidingHash(0).data(), &entry, nullptr, 0));
+    EXPECT_FALSE(txcache_get(&cache, collidingHash(1).data(), &entry, nullptr, 0));
+
+    txcache_stats_t stats;
+    txcache_stats(&cache, &stats);
+    EXPECT_THAT(stats.evictions, testing::Eq(1u));
+    EXPECT_THAT(stats.inserts, testing::Eq(TXCACHE_PROBE + 1));
+    txcache_destroy(&cache);
+}
+
+TEST(TxCache, ConcurrentChecks) {
+    vector<txcache_slot_t> slots(1024);
+    txcache_t cache;
+    ASSERT_THAT(txcache_init(&cache, slots.data(), slots.size(), nullptr, 0), testing::Eq(zxerr_ok));
+
+    // Distinct blobs only, so every blob is inserted exactly once
+    vector<vector<uint8_t>> blobs;
+    set<string> seen;
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        if (!seen.insert(tc.blob).second) {
+            continue;
+        }
+        blobs.push_back(decodeBlob(tc.blob));
+    }
+
+    const int threadCount = 4;
+    const int rounds = 50;
+    vector<thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&]() {
+            for (int r = 0; r < rounds; r++) {
+                for (const auto &blob : blobs) {
+                    txcache_entry_t entry;
+                    EXPECT_THAT(txcache_check(&cache, blob.data(), blob.size(), &entry), testing::Eq(parser_ok));
+                }
+            }
+        });
+    }
+    for (auto &th : threads) {
+        th.join();
+    }
+
+    txcache_stats_t stats;
+    txcache_stats(&cache, &stats);
+    EXPECT_THAT(stats.hits + stats.misses, testing::Eq((uint64_t) threadCount * rounds * blobs.size()));
+    EXPECT_THAT(stats.inserts, testing::Eq(blobs.size()));
+    EXPECT_THAT(stats.misses, testing::Ge(blobs.size()));
+    txcache_destroy(&cache);
+}
@@ -0,0 +1,120 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gmock/gmock.h"
+
+#include <cstdio>
+#include <unistd.h>
+#include <vector>
+#include "common.h"
+#include "parser_impl.h"
+#include "txindex.h"
+
+using namespace std;
+
+TEST(TxIndex, RoundTrip) {
+    // All transactions back to back, as in a blob file
+    vector<uint8_t> blobs;
+    vector<txindex_record_t> records;
+    for (const auto &tc : GetJsonTestCases("testcases.json")) {
+        const auto blob = decodeBlob(tc.blob);
+        txindex_record_t record;
+        txindex_encode(blob.data(), (uint16_t) blob.size(), blobs.size(), &record);
+        records.push_back(record);
+        blobs.insert(blobs.end(), blob.begin(), blob.end());
+    }
+    // And a broken one
+    const uint8_t broken[] = {0xC1, 0x80};
+    txindex_record_t record;
+    txindex_encode(broken, sizeof(broken), blobs.size(), &record);
+    records.push_back(record);
+    blobs.insert(blobs.end(), broken, broken + sizeof(broken));
+
+    const string path = tempPath("txindex_");
+    ASSERT_THAT(txindex_writeFile(path.c_str(), records.data(), (uint32_t) records.size()), testing::Eq(zxerr_ok));
+
+    txindex_t index;
+    ASSERT_THAT(txindex_open(&index, path.c_str()), testing::Eq(zxerr_ok));
+    ASSERT_THAT(index.count, testing::Eq(records.size()));
+    EXPECT_TRUE(txindex_get(&index, index.count) == nullptr);
+
+    for (uint32_t i = 0; i < index.count; i++) {
+        const txindex_record_t *r = txindex_get(&index, i);
+        ASSERT_TRUE(r != nullptr);
+        const uint8_t *blob = blobs.data() + r->blobOffset;
+
+        parser_tx_t expected;
+        const parser_error_t err = readBlob(blob, r->blobLen, &expected);
+
+        parser_tx_t tx;
+        ASSERT_THAT(txindex_view(r, blob, r->blobLen, &tx), testing::Eq(err));
+        if (err != parser_ok) {
+            continue;
+        }
+        EXPECT_TRUE(sameSpan(tx.root, expected.root));
+        for (uint16_t f = 0; f < MANTX_ROOTFIELD_COUNT; f++) {
+            EXPECT_TRUE(sameSpan(tx.fields[f], expected.fields[f])) << i << " field " << f;
+        }
+        ASSERT_THAT(tx.extraFieldsItems, testing::Eq(expected.extraFieldsItems));
+        for (uint16_t f = 0; f < tx.extraFieldsItems; f++) {
+            EXPECT_TRUE(sameSpan(tx.extraFields[f], expected.extraFields[f]));
+        }
+        ASSERT_THAT(tx.extraToFieldsItems, testing::Eq(expected.extraToFieldsItems));
+        for (uint16_t f = 0; f < tx.extraToFieldsItems; f++) {
+            EXPECT_TRUE(sameSpan(tx.extraToListFields[f], expected.extraToListFields[f]));
+        }
+        EXPECT_THAT(tx.extraTxType, testing::Eq(expected.extraTxType));
+
+        // A record never reaches past the blob it is given
+        parser_tx_t shorter;
+        EXPECT_THAT(txindex_view(r, blob, r->blobLen - 1, &shorter), testing::Eq(parser_unexpected_value));
+        txindex_record_t bad = *r;
+        bad.nodes[TXINDEX_NODE_FIELDS].offset = r->blobLen;
+        bad.kinds[TXINDEX_NODE_FIELDS] = RLP_KIND_STRING;
+        bad.nodes[TXINDEX_NODE_FIELDS].len = 1;
+        EXPECT_THAT(txindex_view(&bad, blob, r->blobLen, &shorter), testing::Eq(parser_unexpected_buffer_end));
+    }
+
+    txindex_close(&index);
+    remove(path.c_str());
+}
+
+TEST(TxIndex, RejectsBadFiles) {
+    txindex_t index;
+    EXPECT_THAT(txindex_open(&index, "/nonexistent/txindex"), testing::Eq(zxerr_no_data));
+
+    txindex_record_t record;
+    const uint8_t broken[] = {0xC0};
+    txindex_encode(broken, sizeof(broken), 0, &record);
+    const string path = tempPath("txindex_");
+    ASSERT_THAT(txindex_writeFile(path.c_str(), &record, 1), testing::Eq(zxerr_ok));
+
+    // Truncated
+    ASSERT_THAT(truncate(path.c_str(), sizeof(txindex_header_t) + 10), testing::Eq(0));
+    EXPECT_THAT(txindex_open(&index, path.c_str()), testing::Eq(zxerr_encoding_failed));
+
+    // Wrong version
+    ASSERT_THAT(txindex_writeFile(path.c_str(), &record, 1), testing::Eq(zxerr_ok));
+    FILE *f = fopen(path.c_str(), "r+b");
+    ASSERT_TRUE(f != nullptr);
+    const uint16_t version = TXINDEX_VERSION + 1;
+    fseek(f, TXINDEX_MAGIC_LEN, SEEK_SET);
+    fwrite(&version, sizeof(version), 1, f);
+    fclose(f);
+    EXPECT_THAT(txindex_open(&index, path.c_str()), testing::Eq(zxerr_encoding_failed));
+
+    remove(path.c_str());
+}